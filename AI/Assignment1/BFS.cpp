@@ -1,14 +1,11 @@
 #include <iostream>
-#include <queue>
-#include <set>
-#include <map>
+#include <string>
 #include <vector>
-#include <algorithm>
+#include "../common/search.h"
+#include "sliding_puzzle.h"
 
 using namespace std;
 
-string goal = "123456780"; // goal state (0 = blank)
-
 // Print 3x3 puzzle
 void printState(string s)
 {
@@ -21,68 +18,27 @@ void printState(string s)
     cout << "\n";
 }
 
-// Moves for blank (up, down, left, right)
-vector<int> moves = {-3, 3, -1, 1};
-
-// Check if move is valid
-bool isValid(int pos, int move)
-{
-    if (pos % 3 == 0 && move == -1)
-        return false; // left edge
-    if (pos % 3 == 2 && move == 1)
-        return false; // right edge
-    int newPos = pos + move;
-    return (newPos >= 0 && newPos < 9);
-}
-
+// The puzzle, its moves and the goal "123456780" (0 = blank) are in sliding_puzzle.h
 void BFS(string start)
 {
-    queue<string> q;
-    set<string> visited;
-    map<string, string> parent;
-
-    q.push(start);
-    visited.insert(start);
-    parent[start] = "";
-
-    while (!q.empty())
+    EightPuzzle puzzle;
+    EightPuzzle::State state;
+    if (!EightPuzzle::parse(start, state))
     {
-        string state = q.front();
-        q.pop();
-
-        if (state == goal)
-        {
-            cout << "\nBFS Solution Path:\n";
-            vector<string> path;
-            while (state != "")
-            {
-                path.push_back(state);
-                state = parent[state];
-            }
-            reverse(path.begin(), path.end());
-            for (auto &s : path)
-            {
-                printState(s);
-                cout << "-----\n";
-            }
-            return;
-        }
+        cout << "Invalid start state.\n";
+        return;
+    }
 
-        int pos = state.find('0');
-        for (int m : moves)
+    Search<EightPuzzle> search;
+    if (search.breadthFirst(puzzle, state))
+    {
+        cout << "\nBFS Solution Path:\n";
+        for (auto s : search.path())
         {
-            if (isValid(pos, m))
-            {
-                string next = state;
-                swap(next[pos], next[pos + m]);
-                if (!visited.count(next))
-                {
-                    visited.insert(next);
-                    parent[next] = state;
-                    q.push(next);
-                }
-            }
+            printState(EightPuzzle::format(s));
+            cout << "-----\n";
         }
+        return;
     }
 
     cout << "No solution found using BFS.\n";
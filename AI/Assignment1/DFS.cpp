@@ -1,13 +1,11 @@
 #include <iostream>
-#include <set>
-#include <map>
+#include <string>
 #include <vector>
-#include <algorithm>
+#include "../common/search.h"
+#include "sliding_puzzle.h"
 
 using namespace std;
 
-string goal = "123456780"; // goal state
-
 // Print 3x3 puzzle
 void printState(string s)
 {
@@ -20,65 +18,24 @@ void printState(string s)
     cout << "\n";
 }
 
-vector<int> moves = {-3, 3, -1, 1};
-
-// Check if move is valid
-bool isValid(int pos, int move)
-{
-    if (pos % 3 == 0 && move == -1)
-        return false;
-    if (pos % 3 == 2 && move == 1)
-        return false;
-    int newPos = pos + move;
-    return (newPos >= 0 && newPos < 9);
-}
-
-bool DFSUtil(string state, set<string> &visited, map<string, string> &parent, int depth, int limit)
+// Depth-limited DFS over the puzzle in sliding_puzzle.h (goal "123456780")
+void DFS(string start, int limit = 20)
 {
-    if (state == goal)
-        return true;
-    if (depth >= limit)
-        return false;
-
-    visited.insert(state);
-    int pos = state.find('0');
-
-    for (int m : moves)
+    EightPuzzle puzzle;
+    EightPuzzle::State state;
+    if (!EightPuzzle::parse(start, state))
     {
-        if (isValid(pos, m))
-        {
-            string next = state;
-            swap(next[pos], next[pos + m]);
-            if (!visited.count(next))
-            {
-                parent[next] = state;
-                if (DFSUtil(next, visited, parent, depth + 1, limit))
-                    return true;
-            }
-        }
+        cout << "Invalid start state.\n";
+        return;
     }
-    return false;
-}
-
-void DFS(string start, int limit = 20)
-{
-    set<string> visited;
-    map<string, string> parent;
 
-    if (DFSUtil(start, visited, parent, 0, limit))
+    Search<EightPuzzle> search;
+    if (search.depthFirst(puzzle, state, limit))
     {
         cout << "\nDFS Solution Path:\n";
-        vector<string> path;
-        string state = goal;
-        while (state != "")
-        {
-            path.push_back(state);
-            state = parent[state];
-        }
-        reverse(path.begin(), path.end());
-        for (auto &s : path)
+        for (auto s : search.path())
         {
-            printState(s);
+            printState(EightPuzzle::format(s));
             cout << "-----\n";
         }
     }
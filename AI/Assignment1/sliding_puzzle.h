@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+
+// The Side x Side sliding tile puzzle (the 8-puzzle for Side = 3, the
+// 15-puzzle for Side = 4) as a problem for Search in ../common/search.h.
+//
+// A state packs one tile per 4 bits, cell i in bits 4i .. 4i + 3, with 0 for
+// the blank, so states are plain integers that hash and compare in one
+// instruction. As text a state lists the tiles row by row, e.g. "103425786";
+// tiles above 9 are written as letters A .. F. The goal is 1, 2, ... with the
+// blank last.
+template <unsigned Side>
+class SlidingPuzzle
+{
+    static_assert(Side >= 2 && Side <= 4, "a state holds at most 16 tiles");
+
+public:
+    using State = uint64_t;
+    using Cost = uint32_t;
+
+    static constexpr unsigned CELLS = Side * Side;
+
+    SlidingPuzzle()
+    {
+        for (unsigned tile = 1; tile < CELLS; tile++)
+        {
+            goal |= static_cast<State>(tile) << (4 * (tile - 1));
+            for (unsigned cell = 0; cell < CELLS; cell++)
+            {
+                int rows = static_cast<int>(cell / Side) - static_cast<int>((tile - 1) / Side);
+                int columns = static_cast<int>(cell % Side) - static_cast<int>((tile - 1) % Side);
+                manhattan[tile][cell] = static_cast<uint8_t>(std::abs(rows) + std::abs(columns));
+            }
+        }
+    }
+
+    // Returns false unless `text` holds every tile exactly once
+    static bool parse(std::string_view text, State &state)
+    {
+        if (text.size() != CELLS)
+            return false;
+        state = 0;
+        unsigned seen = 0;
+        for (unsigned cell = 0; cell < CELLS; cell++)
+        {
+            char c = text[cell];
+            unsigned tile = c >= '0' && c <= '9' ? c - '0' : c >= 'A' && c <= 'F' ? c - 'A' + 10 : CELLS;
+            if (tile >= CELLS || (seen >> tile & 1))
+                return false;
+            seen |= 1u << tile;
+            state |= static_cast<State>(tile) << (4 * cell);
+        }
+        return true;
+    }
+
+    static std::string format(State state)
+    {
+        std::string text(CELLS, '0');
+        for (unsigned cell = 0; cell < CELLS; cell++)
+            text[cell] = "0123456789ABCDEF"[tile(state, cell)];
+        return text;
+    }
+
+    static unsigned tile(State state, unsigned cell)
+    {
+        return static_cast<unsigned>(state >> (4 * cell)) & 15;
+    }
+
+    static unsigned blank(State state)
+    {
+        unsigned cell = 0;
+        while (tile(state, cell) != 0)
+            cell++;
+        return cell;
+    }
+
+    // Half of all arrangements cannot reach the goal. With the blank in the
+    // goal row parity, a state is solvable when its tile order has an even
+    // number of inversions (odd Side), or when inversions plus the blank's
+    // row distance to the bottom are even (even Side).
+    static bool isSolvable(State state)
+    {
+        unsigned inversions = 0;
+        for (unsigned i = 0; i < CELLS; i++)
+        {
+            for (unsigned j = i + 1; j < CELLS; j++)
+            {
+                unsigned a = tile(state, i), b = tile(state, j);
+                inversions += a != 0 && b != 0 && a > b;
+            }
+        }
+        if (Side % 2 == 1)
+            return inversions % 2 == 0;
+        return (inversions + (Side - 1 - blank(state) / Side)) % 2 == 0;
+    }
+
+    // A uniformly random solvable state
+    template <class Rng>
+    static State random(Rng &rng)
+    {
+        unsigned tiles[CELLS];
+        for (unsigned i = 0; i < CELLS; i++)
+            tiles[i] = i;
+        std::shuffle(tiles, tiles + CELLS, rng);
+        State state = 0;
+        for (unsigned cell = 0; cell < CELLS; cell++)
+            state |= static_cast<State>(tiles[cell]) << (4 * cell);
+        if (!isSolvable(state))
+        {
+            // Swapping two tiles flips the parity
+            unsigned a = tile(state, 0) != 0 ? 0 : 2, b = tile(state, 1) != 0 ? 1 : 2;
+            State ta = tile(state, a), tb = tile(state, b);
+            state ^= (ta ^ tb) << (4 * a) | (ta ^ tb) << (4 * b);
+        }
+        return state;
+    }
+
+    State goalState() const
+    {
+        return goal;
+    }
+
+    bool isGoal(State state) const
+    {
+        return state == goal;
+    }
+
+    // Slides a neighbouring tile into the blank: the blank moves up, down,
+    // left or right
+    template <class Visit>
+    void successors(State state, Visit &&visit) const
+    {
+        unsigned from = blank(state);
+        auto slide = [&](unsigned to)
+        {
+            State moved = static_cast<State>(tile(state, to));
+            visit(state ^ (moved << (4 * to)) ^ (moved << (4 * from)), Cost(1));
+        };
+        if (from >= Side)
+            slide(from - Side);
+        if (from + Side < CELLS)
+            slide(from + Side);
+        if (from % Side != 0)
+            slide(from - 1);
+        if (from % Side != Side - 1)
+            slide(from + 1);
+    }
+
+    uint64_t hash(State state) const
+    {
+        return state;
+    }
+
+    // Sum of the Manhattan distances of the tiles to their goal cells
+    Cost heuristic(State state) const
+    {
+        Cost h = 0;
+        for (unsigned cell = 0; cell < CELLS; cell++)
+            h += manhattan[tile(state, cell)][cell];
+        return h;
+    }
+
+private:
+    State goal = 0;
+    uint8_t manhattan[CELLS][CELLS] = {}; // [tile][cell]; row 0 (the blank) stays 0
+};
+
+using EightPuzzle = SlidingPuzzle<3>;
@@ -1,5 +1,5 @@
 #include <iostream>
-#include <cstring> // For strcmp (string comparison) and strncpy
+#include "graph_coloring.h"
 
 // --- Global Constants (Variables and Domain) ---
 const int NUM_REGIONS = 7;
@@ -27,111 +27,6 @@ const int ADJACENCIES[][2] = {
 };
 const int NUM_CONSTRAINTS = sizeof(ADJACENCIES) / sizeof(ADJACENCIES[0]);
 
-// --- Assignment Storage ---
-// Use a C-style array to store the color assigned to each region index.
-// Index 0 stores the color for REGIONS[0] ("WA"), etc.
-// The maximum length of a color string is 5 ("Green"), plus 1 for the null terminator.
-const int MAX_COLOR_LEN = 6;
-char assignment[NUM_REGIONS][MAX_COLOR_LEN];
-
-// --- Function Prototypes ---
-bool isConsistent(int regionIndex, const char *color);
-bool backtrack(int regionIndex);
-void solveAndPrint();
-
-// -----------------------------------------------------------------
-// --- Constraint Checking Logic ---
-// -----------------------------------------------------------------
-
-/**
- * Checks if the two given regions (by index) are adjacent.
- */
-bool isAdjacent(int r1, int r2)
-{
-    for (int i = 0; i < NUM_CONSTRAINTS; ++i)
-    {
-        // Constraints are unordered, check both directions
-        if ((ADJACENCIES[i][0] == r1 && ADJACENCIES[i][1] == r2) ||
-            (ADJACENCIES[i][0] == r2 && ADJACENCIES[i][1] == r1))
-        {
-            return true;
-        }
-    }
-    return false;
-}
-
-/**
- * Checks if assigning a color to a region is consistent with previous assignments.
- * This is the simplified equivalent of the Map Coloring CSP constraint.
- */
-bool isConsistent(int regionIndex, const char *color)
-{
-    // Only check against regions that have ALREADY been assigned (index < regionIndex)
-    for (int previousIndex = 0; previousIndex < regionIndex; ++previousIndex)
-    {
-
-        // 1. Check Adjacency
-        if (isAdjacent(regionIndex, previousIndex))
-        {
-
-            // 2. Check Color Conflict
-            const char *previousColor = assignment[previousIndex];
-
-            // strcmp returns 0 if strings are equal
-            if (strcmp(previousColor, color) == 0)
-            {
-                return false; // Conflict: adjacent regions have the same color
-            }
-        }
-    }
-    return true;
-}
-
-// -----------------------------------------------------------------
-// --- Backtracking Search Logic ---
-// -----------------------------------------------------------------
-
-bool backtrack(int regionIndex)
-{
-    // Base Case: If all regions are assigned (regionIndex equals NUM_REGIONS)
-    if (regionIndex == NUM_REGIONS)
-    {
-        return true;
-    }
-
-    // Try every color (domain value) for the current region (variable)
-    for (int colorIndex = 0; colorIndex < NUM_COLORS; ++colorIndex)
-    {
-        const char *color = COLORS[colorIndex];
-
-        // Check consistency BEFORE making a permanent assignment
-        if (isConsistent(regionIndex, color))
-        {
-
-            // 1. Tentatively assign the value (C-style string copy)
-            // strncpy is used for safety to prevent buffer overflow
-            strncpy(assignment[regionIndex], color, MAX_COLOR_LEN - 1);
-            assignment[regionIndex][MAX_COLOR_LEN - 1] = '\0'; // Ensure null termination
-
-            // 2. Recurse to the next region
-            if (backtrack(regionIndex + 1))
-            {
-                return true; // Solution found!
-            }
-
-            // 3. Backtrack (Unassigning is implicitly handled by overwriting
-            // or by not needing to clear for this specific implementation,
-            // since only forward indices are checked. We can set to empty
-            // for clarity, but it's not strictly necessary here.)
-            // For a formal un-assignment:
-            assignment[regionIndex][0] = '\0';
-        }
-    }
-
-    // If no color works for this region, return false
-    return false;
-}
-
 // -----------------------------------------------------------------
 // --- Main Execution and Print ---
 // -----------------------------------------------------------------
@@ -140,18 +35,18 @@ void solveAndPrint()
 {
     std::cout << "Starting Simple C++ Backtracking Search for Australia Map Coloring..." << std::endl;
     std::cout << "Colors(Domains) : Red Green Blue";
-    // Initialize assignment array to empty strings
-    for (int i = 0; i < NUM_REGIONS; ++i)
+    GraphColoringCSP csp(NUM_REGIONS, NUM_COLORS);
+    for (int i = 0; i < NUM_CONSTRAINTS; ++i)
     {
-        assignment[i][0] = '\0';
+        csp.addConstraint(ADJACENCIES[i][0], ADJACENCIES[i][1]);
     }
 
-    if (backtrack(0))
+    if (csp.solve())
     {
         std::cout << "\n--- Solution Found ---" << std::endl;
         for (int i = 0; i < NUM_REGIONS; ++i)
         {
-            std::cout << REGIONS[i] << ": " << assignment[i] << std::endl;
+            std::cout << REGIONS[i] << ": " << COLORS[csp.color(i)] << std::endl;
         }
         std::cout << "----------------------" << std::endl;
     }
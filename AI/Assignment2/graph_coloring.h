@@ -0,0 +1,134 @@
+#pragma once
+
+#include <random>
+#include <vector>
+
+#include "../common/instrumentation.h"
+
+// Map coloring as a CSP: every region (variable) gets one of `colors` colors
+// (its domain) so that no two adjacent regions share a color.
+//
+// The search is plain backtracking: regions are colored in index order and a
+// color is checked only against the neighbours colored before it. Neighbours
+// are kept as adjacency lists, so a check costs O(degree) instead of a scan
+// over every constraint.
+class GraphColoringCSP
+{
+public:
+    static constexpr int NO_COLOR = -1;
+
+    GraphColoringCSP(int regions, int colors) : numColors(colors), neighbors(regions), assignment(regions, NO_COLOR) {}
+
+    // Adjacent regions must get different colors
+    void addConstraint(int r1, int r2)
+    {
+        neighbors[r1].push_back(r2);
+        neighbors[r2].push_back(r1);
+        constraints++;
+    }
+
+    int regionCount() const
+    {
+        return static_cast<int>(neighbors.size());
+    }
+
+    int colorCount() const
+    {
+        return numColors;
+    }
+
+    size_t constraintCount() const
+    {
+        return constraints;
+    }
+
+    /**
+     * Checks if assigning a color to a region is consistent with the regions
+     * colored before it (index < regionIndex).
+     */
+    bool isConsistent(int regionIndex, int color) const
+    {
+        for (int neighbor : neighbors[regionIndex])
+        {
+            if (neighbor < regionIndex && assignment[neighbor] == color)
+                return false; // Conflict: adjacent regions have the same color
+        }
+        return true;
+    }
+
+    bool backtrack(int regionIndex)
+    {
+        // Base Case: all regions are assigned
+        if (regionIndex == regionCount())
+            return true;
+
+        // Every color of this region is a candidate assignment
+        expandedRegions.add();
+        generatedColors.add(numColors);
+
+        // Try every color (domain value) for the current region (variable)
+        for (int color = 0; color < numColors; ++color)
+        {
+            if (isConsistent(regionIndex, color))
+            {
+                assignment[regionIndex] = color;
+                if (backtrack(regionIndex + 1))
+                    return true; // Solution found!
+                assignment[regionIndex] = NO_COLOR;
+                backtracks.add();
+            }
+        }
+
+        // If no color works for this region, return false
+        return false;
+    }
+
+    // Colors every region; returns false if the constraints cannot be met
+    bool solve()
+    {
+        AI_PHASE("graph_coloring.solve");
+        assignment.assign(neighbors.size(), NO_COLOR);
+        bool solved = backtrack(0);
+        expandedRegions.flush();
+        generatedColors.flush();
+        backtracks.flush();
+        return solved;
+    }
+
+    // Color index of a region after solve(), or NO_COLOR
+    int color(int region) const
+    {
+        return assignment[region];
+    }
+
+private:
+    int numColors;
+    std::vector<std::vector<int>> neighbors;
+    std::vector<int> assignment;
+    size_t constraints = 0;
+
+    // Search counts for instrumentation.h, reported after each solve()
+    CounterTally<Counter::NodesExpanded> expandedRegions;
+    CounterTally<Counter::NodesGenerated> generatedColors;
+    CounterTally<Counter::Backtracks> backtracks;
+};
+
+// --- Benchmark generators ---
+
+// A random map of `regions` regions where each pair is adjacent with
+// probability `density` (an Erdos-Renyi graph)
+inline GraphColoringCSP makeRandomColoring(int regions, double density, int colors, unsigned seed)
+{
+    GraphColoringCSP csp(regions, colors);
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution adjacent(density);
+    for (int a = 0; a < regions; a++)
+    {
+        for (int b = a + 1; b < regions; b++)
+        {
+            if (adjacent(rng))
+                csp.addConstraint(a, b);
+        }
+    }
+    return csp;
+}
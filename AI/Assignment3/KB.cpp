@@ -1,151 +1,283 @@
 #include <iostream>
-#include <unordered_map>
 #include <vector>
 #include <string>
-#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <atomic>
+#include "knowledge_base.h"
+#include "family_loader.h"
+#include "family_service.h"
 
 using namespace std;
 
-class KnowledgeBase
+// Helper function to print vectors
+void printVector(const vector<string> &vec)
 {
-private:
-    // Store parent -> children relationships
-    unordered_map<string, vector<string>> parentMap;
-    // Store gender info
-    unordered_map<string, string> genderMap;
-
-public:
-    // Add parent-child relationship
-    void addParent(const string &parent, const string &child)
+    cout << "[";
+    for (size_t i = 0; i < vec.size(); ++i)
     {
-        parentMap[parent].push_back(child);
+        cout << vec[i];
+        if (i != vec.size() - 1)
+            cout << ", ";
     }
+    cout << "]";
+}
 
-    // Add gender info
-    void addGender(const string &person, const string &gender)
+// Prints what `other` is to `person`, e.g. "Bob is Charlie's uncle/aunt"
+void printRelationship(KnowledgeBase &kb, const string &person, const string &other)
+{
+    PersonId a = kb.find(person), b = kb.find(other);
+    if (a == NO_PERSON || b == NO_PERSON || !kb.relationship(a, b).related())
+        cout << other << " and " << person << " are not related\n";
+    else
+        cout << other << " is " << person << "'s " << kb.getRelationship(person, other) << "\n";
+}
+
+double secondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Usage: KB --bench <people> [generation size] [queries]
+// Builds a synthetic family tree and times every relation on random people.
+int runBenchmark(int argc, char *argv[])
+{
+    size_t people = strtoull(argv[2], nullptr, 10);
+    size_t generation = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1000;
+    size_t queries = argc > 4 ? strtoull(argv[4], nullptr, 10) : 1000000;
+    if (people == 0)
+        return 0;
+
+    KnowledgeBase kb;
+    auto start = chrono::steady_clock::now();
+    makeFamilyTree(kb, people, generation, 42);
+    cout << "Generated " << kb.personCount() << " people in " << secondsSince(start) << " s\n";
+    start = chrono::steady_clock::now();
+    auto family = kb.snapshot();
+    cout << "Indexed " << family->linkCount() << " links in " << secondsSince(start) << " s\n";
+
+    vector<PersonId> persons(queries);
+    mt19937 rng(7);
+    for (auto &p : persons)
+        p = static_cast<PersonId>(rng() % people);
+
+    KinshipSearch search;
+    auto measure = [&](const char *relation, auto query)
     {
-        genderMap[person] = gender;
+        size_t found = 0;
+        auto begin = chrono::steady_clock::now();
+        for (PersonId p : persons)
+            found += query(p).size();
+        double seconds = secondsSince(begin);
+        cout << relation << ": " << seconds * 1e9 / persons.size() << " ns/query, "
+             << static_cast<double>(found) / persons.size() << " results/query\n";
+    };
+    measure("Children", [&](PersonId p)
+            { return family->children(p); });
+    measure("Parents", [&](PersonId p)
+            { return family->parents(p); });
+    measure("Grandparents", [&](PersonId p)
+            { return search.grandparents(*family, p); });
+    measure("Siblings", [&](PersonId p)
+            { return search.siblings(*family, p); });
+    measure("Uncles/Aunts", [&](PersonId p)
+            { return search.unclesAunts(*family, p); });
+    measure("Nephews/Nieces", [&](PersonId p)
+            { return search.nephewsNieces(*family, p); });
+
+    // Kinship queries; the second person is from the same generation, or the
+    // one four before for ancestor tests
+    const KinshipIndex &index = kb.kinship();
+    vector<PersonId> others(queries);
+    for (size_t i = 0; i < queries; i++)
+    {
+        size_t first = persons[i] / generation * generation;
+        others[i] = static_cast<PersonId>(first + rng() % generation);
     }
-
-    // Get children of a person
-    vector<string> getChildren(const string &person)
+    auto measurePairs = [&](const char *relation, auto query)
     {
-        if (parentMap.find(person) != parentMap.end())
-            return parentMap[person];
-        else
-            return {};
+        size_t found = 0;
+        auto begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < queries; i++)
+            found += query(persons[i], others[i]);
+        double seconds = secondsSince(begin);
+        cout << relation << ": " << seconds * 1e9 / queries << " ns/query, " << static_cast<double>(found) / queries
+             << " hits/query\n";
+    };
+    measurePairs("Is ancestor (4 generations up)", [&](PersonId p, PersonId q)
+                 { return q >= 4 * generation && search.isAncestor(*family, index, q - 4 * generation, p); });
+    measure("Ancestors 3 links up", [&](PersonId p)
+            { return search.ancestorsAt(*family, index, p, 3); });
+    measurePairs("Related within 4 links", [&](PersonId p, PersonId q)
+                 { return search.relationship(*family, p, q, 4).related(); });
+    measure("First cousins", [&](PersonId p)
+            { return search.cousins(*family, p, 1, 0); });
+
+    // Adding 0.1% more people and refreezing updates the index in place
+    size_t added = max<size_t>(people / 1000, 1);
+    for (size_t i = 0; i < added; i++)
+    {
+        PersonId child = kb.intern("new" + to_string(i));
+        kb.addParent(static_cast<PersonId>(rng() % people), child);
+        kb.addParent(static_cast<PersonId>(rng() % people), child);
     }
+    start = chrono::steady_clock::now();
+    kb.snapshot();
+    cout << "Refrozen after " << added << " new people in " << secondsSince(start) << " s\n";
+    return 0;
+}
+
+// Usage: KB --bench-service <people> [max threads] [queries per thread]
+// Serves queries from 1, 2, 4, ... reader threads while a writer keeps adding
+// people and publishing new versions.
+int runServiceBenchmark(int argc, char *argv[])
+{
+    size_t people = strtoull(argv[2], nullptr, 10);
+    size_t maxThreads = argc > 3 ? strtoull(argv[3], nullptr, 10) : thread::hardware_concurrency();
+    size_t queries = argc > 4 ? strtoull(argv[4], nullptr, 10) : 1000000;
+    if (people == 0)
+        return 0;
 
-    // Get parents of a person
-    vector<string> getParents(const string &person)
+    FamilyService service;
     {
-        vector<string> parents;
-        for (auto &entry : parentMap)
-        {
-            if (find(entry.second.begin(), entry.second.end(), person) != entry.second.end())
-            {
-                parents.push_back(entry.first);
-            }
-        }
-        return parents;
+        KnowledgeBase kb;
+        makeFamilyTree(kb, people, 1000, 42);
+        service.addRecords(kb.release());
     }
+    auto start = chrono::steady_clock::now();
+    service.publish();
+    cout << "Published " << people << " people in " << secondsSince(start) << " s\n";
 
-    // Get grandparents of a person
-    vector<string> getGrandparents(const string &person)
+    for (size_t threads = 1; threads <= max<size_t>(maxThreads, 1); threads *= 2)
     {
-        vector<string> grandparents;
-        for (const string &parent : getParents(person))
-        {
-            vector<string> gp = getParents(parent);
-            grandparents.insert(grandparents.end(), gp.begin(), gp.end());
-        }
-        return grandparents;
+        atomic<bool> done{false};
+        atomic<size_t> publishes{0};
+        thread writer([&]
+                      {
+                          mt19937 rng(static_cast<unsigned>(threads));
+                          for (size_t batch = 0; !done.load(memory_order_relaxed); batch++)
+                          {
+                              for (size_t i = 0; i < 100; i++)
+                              {
+                                  string child = "t" + to_string(threads) + "_" + to_string(batch) + "_" + to_string(i);
+                                  service.addParent("p" + to_string(rng() % people), child);
+                              }
+                              service.publish();
+                              publishes++;
+                          } });
+
+        vector<thread> readers;
+        vector<size_t> found(threads);
+        auto begin = chrono::steady_clock::now();
+        for (size_t t = 0; t < threads; t++)
+            readers.emplace_back([&, t]
+                                 {
+                                     FamilyService::Reader reader(service);
+                                     mt19937 rng(static_cast<unsigned>(t + 1));
+                                     size_t hits = 0;
+                                     for (size_t q = 0; q < queries; q++)
+                                     {
+                                         PersonId p = static_cast<PersonId>(rng() % people);
+                                         hits += reader.read([&](const FamilyService::Version &v, KinshipSearch &search)
+                                                                 { return search.siblings(*v.family, p).size() +
+                                                                          search.grandparents(*v.family, p).size(); });
+                                     }
+                                     found[t] = hits;
+                                 });
+        for (auto &reader : readers)
+            reader.join();
+        double seconds = secondsSince(begin);
+        done = true;
+        writer.join();
+        cout << threads << " reader thread(s): " << threads * queries / seconds / 1e6 << " M queries/s, "
+             << publishes << " versions published, " << service.retiredVersions() << " awaiting reclamation\n";
     }
+    return 0;
+}
 
-    // Get siblings of a person
-    vector<string> getSiblings(const string &person)
+// Usage: KB --load <relations.csv> [options]
+//        KB --gedcom <file.ged> [options]
+// Options: --people <people.csv>  genders from a person,gender file
+//          --threads <n>          parser threads (default: all cores)
+//          --query <name>         print the close relatives of one person
+int runLoad(int argc, char *argv[])
+{
+    bool gedcom = strcmp(argv[1], "--gedcom") == 0;
+    string people, query;
+    size_t threads = thread::hardware_concurrency();
+    int next = 3;
+    for (; next + 1 < argc; next += 2)
     {
-        vector<string> siblings;
-        for (const string &parent : getParents(person))
-        {
-            for (const string &child : getChildren(parent))
-            {
-                if (child != person && find(siblings.begin(), siblings.end(), child) == siblings.end())
-                {
-                    siblings.push_back(child);
-                }
-            }
-        }
-        return siblings;
+        string option = argv[next];
+        if (option == "--people")
+            people = argv[next + 1];
+        else if (option == "--threads")
+            threads = strtoull(argv[next + 1], nullptr, 10);
+        else if (option == "--query")
+            query = argv[next + 1];
+        else
+            break;
     }
-    vector<string> getUnclesAunts(const string &person)
+    if (next < argc)
     {
-        vector<string> unclesAunts;
-
-        // Step 1: Find the person's parents
-        vector<string> parents = getParents(person);
-
-        // Step 2: For each parent, find their siblings
-        for (const string &parent : parents)
-        {
-            vector<string> siblings = getSiblings(parent);
-
-            // Step 3: Add them as uncles/aunts (avoid duplicates)
-            for (const string &s : siblings)
-            {
-                if (find(unclesAunts.begin(), unclesAunts.end(), s) == unclesAunts.end())
-                    unclesAunts.push_back(s);
-            }
-        }
-        return unclesAunts;
+        cout << "Unknown option: " << argv[next] << "\n";
+        return 1;
     }
-    vector<string> getNephewsNieces(const string &person)
-    {
-        vector<string> nephewsNieces;
-
-        // Step 1: Find siblings of the person
-        vector<string> siblings = getSiblings(person);
 
-        // Step 2: For each sibling, get their children
-        for (const string &sibling : siblings)
+    try
+    {
+        auto start = chrono::steady_clock::now();
+        FamilyLoader loader(threads);
+        if (gedcom)
+            loader.loadGedcom(argv[2]);
+        else
+            loader.loadRelationsCsv(argv[2]);
+        if (!people.empty())
+            loader.loadPeopleCsv(people);
+        cout << "Parsed " << loader.linkCount() << " links in " << secondsSince(start) << " s\n";
+        start = chrono::steady_clock::now();
+        KnowledgeBase kb;
+        kb.addRecords(loader.finish());
+        cout << "Interned " << kb.personCount() << " people in " << secondsSince(start) << " s\n";
+        start = chrono::steady_clock::now();
+        auto family = kb.snapshot();
+        cout << "Indexed " << family->linkCount() << " distinct links in " << secondsSince(start) << " s\n";
+
+        if (!query.empty())
         {
-            vector<string> children = getChildren(sibling);
-
-            // Step 3: Add those children as nephews/nieces (avoid duplicates)
-            for (const string &child : children)
+            cout << query << " (" << kb.getGender(query) << ")\n";
+            for (auto [relation, relatives] : {pair<const char *, vector<string>>{"Parents", kb.getParents(query)},
+                                               {"Children", kb.getChildren(query)},
+                                               {"Siblings", kb.getSiblings(query)},
+                                               {"Grandparents", kb.getGrandparents(query)},
+                                               {"First cousins", kb.getCousins(query, 1, 0)}})
             {
-                if (find(nephewsNieces.begin(), nephewsNieces.end(), child) == nephewsNieces.end())
-                    nephewsNieces.push_back(child);
+                cout << relation << ": ";
+                printVector(relatives);
+                cout << "\n";
             }
         }
-        return nephewsNieces;
     }
-
-    // Get gender of a person
-    string getGender(const string &person)
+    catch (const exception &e)
     {
-        if (genderMap.find(person) != genderMap.end())
-            return genderMap[person];
-        else
-            return "Unknown";
+        cout << "Error: " << e.what() << "\n";
+        return 1;
     }
-};
-
-// Helper function to print vectors
-void printVector(const vector<string> &vec)
-{
-    cout << "[";
-    for (size_t i = 0; i < vec.size(); ++i)
-    {
-        cout << vec[i];
-        if (i != vec.size() - 1)
-            cout << ", ";
-    }
-    cout << "]";
+    return 0;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
+    if (argc >= 3 && strcmp(argv[1], "--bench") == 0)
+        return runBenchmark(argc, argv);
+    if (argc >= 3 && strcmp(argv[1], "--bench-service") == 0)
+        return runServiceBenchmark(argc, argv);
+    if (argc >= 3 && (strcmp(argv[1], "--load") == 0 || strcmp(argv[1], "--gedcom") == 0))
+        return runLoad(argc, argv);
+
     KnowledgeBase kb;
 
     // Add relationships
@@ -185,6 +317,10 @@ int main()
     cout << "Nephews/Nieces of Alice: ";
     printVector(kb.getNephewsNieces("Alice"));
     cout << "\n";
+
+    printRelationship(kb, "Charlie", "John");
+    printRelationship(kb, "Charlie", "Bob");
+    printRelationship(kb, "Bob", "David");
     return 0;
 }
 
@@ -211,6 +347,7 @@ vector<string> getUnclesAunts(const string &person)
     }
     return unclesAunts;
 }
+*/
 /*🧠 Explanation in simple words:
 
 First, find the person’s parents.
@@ -0,0 +1,478 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../common/thread_pool.h"
+#include "knowledge_base.h"
+
+// Name interning that any number of threads can use at once. Names are
+// spread over SHARDS tables by the high bits of their hash, each with its own
+// lock, so threads rarely wait for each other. The ids handed out are
+// provisional (the shard in the low bits, the index within the shard above
+// it); merge() turns them into dense ids.
+class ShardedNameTable
+{
+public:
+    static constexpr unsigned SHARD_BITS = 6;
+    static constexpr size_t SHARDS = size_t(1) << SHARD_BITS;
+
+    uint32_t intern(std::string_view name)
+    {
+        uint64_t hash = NameTable::hashName(name);
+        size_t s = static_cast<size_t>(hash >> (64 - SHARD_BITS));
+        Shard &shard = shards[s];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        PersonId local = shard.names.insert(name, hash);
+        if (local >= (PersonId(1) << (32 - SHARD_BITS)) - 1)
+            throw std::runtime_error("too many people for 32-bit ids");
+        return local << SHARD_BITS | static_cast<uint32_t>(s);
+    }
+
+    // Moves all names into one table, shard after shard, and sets firstId[s]
+    // to the dense id of the first name of shard s. Leaves this table empty.
+    NameTable merge(std::array<PersonId, SHARDS> &firstId)
+    {
+        size_t names = 0, characters = 0;
+        for (const Shard &shard : shards)
+        {
+            names += shard.names.size();
+            characters += shard.names.characters();
+        }
+        NameTable merged;
+        merged.reserve(names, characters);
+        for (size_t s = 0; s < SHARDS; s++)
+        {
+            firstId[s] = static_cast<PersonId>(merged.size());
+            merged.append(shards[s].names);
+            shards[s].names = NameTable();
+        }
+        return merged;
+    }
+
+    static PersonId dense(uint32_t provisional, const std::array<PersonId, SHARDS> &firstId)
+    {
+        return firstId[provisional & (SHARDS - 1)] + (provisional >> SHARD_BITS);
+    }
+
+private:
+    struct alignas(64) Shard
+    {
+        std::mutex mutex;
+        NameTable names;
+    };
+
+    std::array<Shard, SHARDS> shards;
+};
+
+// Bulk loading of family records from large files.
+//
+// Files are read in blocks of a fixed size, so the memory used besides the
+// records themselves stays bounded by the block size. Each block is cut at
+// record boundaries into pieces that the pool parses in parallel. Names go
+// through a ShardedNameTable, and the parsed links are appended in file
+// order as plain id arrays. They are turned into adjacency lists later by the
+// counting sort in FamilySnapshot, so nothing is inserted into a hash map per
+// link.
+//
+// Formats:
+// - Relations CSV: one "parent,child" line per link.
+// - People CSV: one "person,gender" line per person.
+//   In both, a first line "parent,child" or "person,gender" is a header,
+//   lines starting with '#' are comments, fields may be quoted and further
+//   fields are ignored.
+// - GEDCOM: INDI records give the people and their SEX, and FAM records
+//   link their HUSB and WIFE to every CHIL. People are named by their
+//   cross-reference ids (I12 for "@I12@"), since GEDCOM names need not be
+//   unique.
+class FamilyLoader
+{
+public:
+    explicit FamilyLoader(size_t threads = std::thread::hardware_concurrency(), size_t blockSize = size_t(64) << 20)
+        : pool(threads), blockSize(std::max<size_t>(blockSize, 1024))
+    {
+    }
+
+    void loadRelationsCsv(const std::string &path)
+    {
+        readBlocks(path, false, [this](Piece &piece)
+                   {
+                       std::string_view fields[2];
+                       forEachLine(piece, [&](std::string_view line)
+                                   {
+                                       if (csvFields(line, fields) < 2 || fields[0].empty() || fields[1].empty())
+                                           return fail(piece, "expected parent,child");
+                                       if (piece.firstInFile && piece.lines == 1 && sameText(fields[0], "parent") &&
+                                           sameText(fields[1], "child"))
+                                           return true;
+                                       piece.parents.push_back(names.intern(fields[0]));
+                                       piece.children.push_back(names.intern(fields[1]));
+                                       return true; });
+                   });
+    }
+
+    void loadPeopleCsv(const std::string &path)
+    {
+        readBlocks(path, false, [this](Piece &piece)
+                   {
+                       std::string_view fields[2];
+                       forEachLine(piece, [&](std::string_view line)
+                                   {
+                                       size_t count = csvFields(line, fields);
+                                       if (count == 0 || fields[0].empty())
+                                           return fail(piece, "expected person,gender");
+                                       if (piece.firstInFile && piece.lines == 1 && sameText(fields[0], "person") &&
+                                           count > 1 && sameText(fields[1], "gender"))
+                                           return true;
+                                       piece.genders.emplace_back(names.intern(fields[0]),
+                                                                  count > 1 ? parseGender(fields[1]) : Gender::Unknown);
+                                       return true; });
+                   });
+    }
+
+    void loadGedcom(const std::string &path)
+    {
+        readBlocks(path, true, [this](Piece &piece)
+                   {
+                       enum class Record
+                       {
+                           Other,
+                           Individual,
+                           Family
+                       } record = Record::Other;
+                       uint32_t person = 0;
+                       std::vector<uint32_t> parents, children;
+                       auto endFamily = [&]()
+                       {
+                           for (uint32_t child : children)
+                           {
+                               for (uint32_t parent : parents)
+                               {
+                                   piece.parents.push_back(parent);
+                                   piece.children.push_back(child);
+                               }
+                           }
+                           parents.clear();
+                           children.clear();
+                       };
+                       forEachLine(piece, [&](std::string_view line)
+                                   {
+                                       std::string_view xref, tag, value;
+                                       int level = gedcomLine(line, xref, tag, value);
+                                       if (level < 0)
+                                           return fail(piece, "malformed GEDCOM line");
+                                       if (level == 0)
+                                       {
+                                           endFamily();
+                                           record = Record::Other;
+                                           if (tag == "INDI" && !xref.empty())
+                                           {
+                                               record = Record::Individual;
+                                               person = names.intern(xref);
+                                           }
+                                           else if (tag == "FAM")
+                                               record = Record::Family;
+                                       }
+                                       else if (level == 1 && record == Record::Individual && tag == "SEX")
+                                           piece.genders.emplace_back(person, parseGender(value));
+                                       else if (level == 1 && record == Record::Family && (tag == "HUSB" || tag == "WIFE"))
+                                           parents.push_back(names.intern(stripAt(value)));
+                                       else if (level == 1 && record == Record::Family && tag == "CHIL")
+                                           children.push_back(names.intern(stripAt(value)));
+                                       return true; });
+                       // Pieces start and end at level 0 records
+                       endFamily();
+                   });
+    }
+
+    size_t linkCount() const
+    {
+        return linkParent.size();
+    }
+
+    // Everything loaded so far with dense ids; the loader is empty afterwards
+    FamilyRecords finish()
+    {
+        std::array<PersonId, ShardedNameTable::SHARDS> firstId;
+        FamilyRecords records;
+        records.names = names.merge(firstId);
+        records.genders.assign(records.names.size(), Gender::Unknown);
+        records.linkParent = std::move(linkParent);
+        records.linkChild = std::move(linkChild);
+        pool.parallelFor(records.linkParent.size(), [&](size_t, size_t i)
+                         {
+                             records.linkParent[i] = ShardedNameTable::dense(records.linkParent[i], firstId);
+                             records.linkChild[i] = ShardedNameTable::dense(records.linkChild[i], firstId); },
+                         size_t(1) << 16);
+        // In file order, so the last gender given for a person wins
+        for (const auto &[person, gender] : genders)
+            records.genders[ShardedNameTable::dense(person, firstId)] = gender;
+        linkParent.clear();
+        linkChild.clear();
+        genders.clear();
+        genders.shrink_to_fit();
+        return records;
+    }
+
+private:
+    // A range of whole records of one block and what was parsed from it,
+    // with provisional ids
+    struct Piece
+    {
+        const char *begin = nullptr;
+        const char *end = nullptr;
+        bool firstInFile = false;
+        size_t lines = 0;
+        std::vector<uint32_t> parents;
+        std::vector<uint32_t> children;
+        std::vector<std::pair<uint32_t, Gender>> genders;
+        std::string error; // set with the line that caused it
+        size_t errorLine = 0;
+    };
+
+    ThreadPool pool;
+    size_t blockSize;
+    ShardedNameTable names;
+    std::vector<uint32_t> linkParent;
+    std::vector<uint32_t> linkChild;
+    std::vector<std::pair<uint32_t, Gender>> genders;
+    std::vector<Piece> pieces;
+
+    static bool fail(Piece &piece, const char *what)
+    {
+        piece.error = what;
+        piece.errorLine = piece.lines;
+        return false;
+    }
+
+    // Calls visit(line) for every line of the piece without its line break,
+    // skipping empty lines and '#' comments, until visit returns false
+    template <class Visit>
+    static void forEachLine(Piece &piece, Visit visit)
+    {
+        const char *p = piece.begin;
+        while (p < piece.end)
+        {
+            const char *newline = static_cast<const char *>(std::memchr(p, '\n', piece.end - p));
+            const char *lineEnd = newline ? newline : piece.end;
+            std::string_view line(p, lineEnd - p);
+            p = newline ? newline + 1 : piece.end;
+            piece.lines++;
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            if (piece.firstInFile && piece.lines == 1 && line.substr(0, 3) == "\xEF\xBB\xBF")
+                line.remove_prefix(3); // UTF-8 byte order mark
+            if (line.empty() || line[0] == '#')
+                continue;
+            if (!visit(line))
+                return;
+        }
+    }
+
+    // Reads the file block by block; each block is parsed in parallel pieces
+    // and their results are appended in file order
+    template <class Parse>
+    void readBlocks(const std::string &path, bool gedcom, Parse parse)
+    {
+        std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(path.c_str(), "rb"), std::fclose);
+        if (!file)
+            throw std::runtime_error("cannot open " + path);
+        std::vector<char> buffer(blockSize);
+        size_t filled = 0, lineBase = 0;
+        bool eof = false, first = true;
+        for (;;)
+        {
+            if (!eof)
+            {
+                filled += std::fread(buffer.data() + filled, 1, buffer.size() - filled, file.get());
+                if (std::ferror(file.get()))
+                    throw std::runtime_error("error reading " + path);
+                eof = filled < buffer.size();
+            }
+            if (filled == 0)
+                break;
+            size_t cut = eof ? filled : lastRecordStart(buffer.data(), filled, gedcom);
+            if (cut == 0)
+            {
+                buffer.resize(buffer.size() * 2); // one record longer than the block
+                continue;
+            }
+            parseBlock(buffer.data(), cut, gedcom, first, path, lineBase, parse);
+            first = false;
+            std::memmove(buffer.data(), buffer.data() + cut, filled - cut);
+            filled -= cut;
+        }
+    }
+
+    template <class Parse>
+    void parseBlock(const char *data, size_t size, bool gedcom, bool first, const std::string &path, size_t &lineBase,
+                    Parse &parse)
+    {
+        size_t count = std::max<size_t>(pool.size() * 4, 1);
+        pieces.resize(count);
+        size_t from = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t to = i + 1 == count ? size : nextRecordStart(data, std::max(from, size / count * (i + 1)), size, gedcom);
+            Piece &piece = pieces[i];
+            piece.begin = data + from;
+            piece.end = data + to;
+            piece.firstInFile = first && i == 0;
+            piece.lines = 0;
+            piece.parents.clear();
+            piece.children.clear();
+            piece.genders.clear();
+            piece.error.clear();
+            from = to;
+        }
+        pool.parallelFor(count, [&](size_t, size_t i)
+                         {
+                             Piece &piece = pieces[i];
+                             try
+                             {
+                                 parse(piece);
+                             }
+                             catch (const std::exception &e)
+                             {
+                                 piece.error = e.what();
+                                 piece.errorLine = piece.lines;
+                             } });
+        for (Piece &piece : pieces)
+        {
+            if (!piece.error.empty())
+                throw std::runtime_error(path + ":" + std::to_string(lineBase + piece.errorLine) + ": " + piece.error);
+            linkParent.insert(linkParent.end(), piece.parents.begin(), piece.parents.end());
+            linkChild.insert(linkChild.end(), piece.children.begin(), piece.children.end());
+            genders.insert(genders.end(), piece.genders.begin(), piece.genders.end());
+            lineBase += piece.lines;
+        }
+    }
+
+    // Records are lines, or for GEDCOM a level 0 line and everything up to
+    // the next one
+    static bool isRecordStart(const char *data, size_t i, size_t size, bool gedcom)
+    {
+        return i == 0 || (data[i - 1] == '\n' && (!gedcom || (i < size && data[i] == '0')));
+    }
+
+    static size_t nextRecordStart(const char *data, size_t from, size_t size, bool gedcom)
+    {
+        for (size_t i = from; i < size; i++)
+        {
+            if (isRecordStart(data, i, size, gedcom))
+                return i;
+        }
+        return size;
+    }
+
+    // Start of the last record that is known to be complete, 0 if none is
+    static size_t lastRecordStart(const char *data, size_t size, bool gedcom)
+    {
+        // A GEDCOM record start needs the next byte, so the last one can't be
+        for (size_t i = gedcom ? size - 1 : size; i > 0; i--)
+        {
+            if (isRecordStart(data, i, size, gedcom))
+                return i;
+        }
+        return 0;
+    }
+
+    // Splits the first `N` comma-separated fields of a line, trimming blanks
+    // and surrounding quotes; returns how many there are
+    template <size_t N>
+    static size_t csvFields(std::string_view line, std::string_view (&fields)[N])
+    {
+        size_t count = 0, p = 0;
+        while (count < N && p <= line.size())
+        {
+            while (p < line.size() && (line[p] == ' ' || line[p] == '\t'))
+                p++;
+            size_t end;
+            std::string_view field;
+            if (p < line.size() && line[p] == '"')
+            {
+                size_t close = line.find('"', p + 1);
+                if (close == std::string_view::npos)
+                    close = line.size();
+                field = line.substr(p + 1, close - p - 1);
+                end = line.find(',', close);
+            }
+            else
+            {
+                end = line.find(',', p);
+                field = line.substr(p, (end == std::string_view::npos ? line.size() : end) - p);
+                while (!field.empty() && (field.back() == ' ' || field.back() == '\t'))
+                    field.remove_suffix(1);
+            }
+            fields[count++] = field;
+            if (end == std::string_view::npos)
+                break;
+            p = end + 1;
+        }
+        return count;
+    }
+
+    // Splits "<level> [@xref@] <tag> [value]"; returns the level, or -1 if
+    // the line has none
+    static int gedcomLine(std::string_view line, std::string_view &xref, std::string_view &tag, std::string_view &value)
+    {
+        size_t p = line.find_first_not_of(" \t");
+        if (p == std::string_view::npos || line[p] < '0' || line[p] > '9')
+            return -1;
+        int level = 0;
+        for (; p < line.size() && line[p] >= '0' && line[p] <= '9'; p++)
+            level = level * 10 + (line[p] - '0');
+        auto word = [&]()
+        {
+            while (p < line.size() && line[p] == ' ')
+                p++;
+            size_t end = line.find(' ', p);
+            end = end == std::string_view::npos ? line.size() : end;
+            std::string_view w = line.substr(p, end - p);
+            p = end;
+            return w;
+        };
+        std::string_view first = word();
+        xref = {};
+        if (!first.empty() && first[0] == '@')
+        {
+            xref = stripAt(first);
+            first = word();
+        }
+        tag = first;
+        while (p < line.size() && line[p] == ' ')
+            p++;
+        value = line.substr(std::min(p, line.size()));
+        return level;
+    }
+
+    static std::string_view stripAt(std::string_view text)
+    {
+        if (text.size() >= 2 && text.front() == '@' && text.back() == '@')
+            return text.substr(1, text.size() - 2);
+        return text;
+    }
+
+    static bool sameText(std::string_view text, const char *lower)
+    {
+        if (text.size() != std::strlen(lower))
+            return false;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            if (std::tolower(static_cast<unsigned char>(text[i])) != lower[i])
+                return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/epoch_reclamation.h"
+#include "knowledge_base.h"
+
+// Serves family queries from many threads while new records keep arriving.
+//
+// Every published version is immutable: a family snapshot and its kinship
+// index. Readers reach the current version through an atomic pointer and pin
+// it with an epoch (see EpochDomain), so they never lock, never wait for a
+// writer and never touch a shared reference count. A version stays intact as
+// long as any reader that saw it is still inside.
+//
+// Writers add records to a pending batch. publish() applies the batch to the
+// current version as a delta: the next family snapshot shares with it every
+// block of links, chunk of genders and name table the batch leaves alone (see
+// FamilySnapshot), and the kinship index is updated on a copy that shares its
+// chunks the same way (see SharedChunks). A publish thus costs
+// O(people / PersonLists::BLOCK) plus the blocks and chunks the batch
+// touches, and versions kept alive by slow readers share most of their
+// memory. The next version is swapped in with one atomic store and the old
+// one retired, to be freed once its last reader has left. Versions hold no
+// working memory: each Reader has its own KinshipSearch, and the scratch of
+// index updates stays with the writer.
+class FamilyService
+{
+public:
+    struct Version
+    {
+        uint64_t number = 0;
+        std::shared_ptr<const FamilySnapshot> family;
+        KinshipIndex index;
+    };
+
+    // One per reader thread. Each call answers from the version that is
+    // current when it starts, pinned until it returns.
+    class Reader
+    {
+    public:
+        explicit Reader(FamilyService &service) : service(service), slot(service.epochs.registerReader()) {}
+
+        ~Reader()
+        {
+            service.epochs.unregisterReader(slot);
+        }
+
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        // Runs query(version, search) with the current version pinned; the
+        // version and any span from it must not be used after query returns
+        template <class Query>
+        auto read(Query query)
+        {
+            Pin pin(*this);
+            return query(*pin.version, search);
+        }
+
+        uint64_t version()
+        {
+            return read([](const Version &v, KinshipSearch &)
+                        { return v.number; });
+        }
+
+        std::vector<std::string> getChildren(std::string_view person)
+        {
+            return byName(person, [](const Version &v, KinshipSearch &, PersonId p)
+                          { return v.family->children(p); });
+        }
+
+        std::vector<std::string> getParents(std::string_view person)
+        {
+            return byName(person, [](const Version &v, KinshipSearch &, PersonId p)
+                          { return v.family->parents(p); });
+        }
+
+        std::vector<std::string> getGrandparents(std::string_view person)
+        {
+            return byName(person, [](const Version &v, KinshipSearch &s, PersonId p)
+                          { return s.grandparents(*v.family, p); });
+        }
+
+        std::vector<std::string> getSiblings(std::string_view person)
+        {
+            return byName(person, [](const Version &v, KinshipSearch &s, PersonId p)
+                          { return s.siblings(*v.family, p); });
+        }
+
+        std::vector<std::string> getUnclesAunts(std::string_view person)
+        {
+            return byName(person, [](const Version &v, KinshipSearch &s, PersonId p)
+                          { return s.unclesAunts(*v.family, p); });
+        }
+
+        std::vector<std::string> getNephewsNieces(std::string_view person)
+        {
+            return byName(person, [](const Version &v, KinshipSearch &s, PersonId p)
+                          { return s.nephewsNieces(*v.family, p); });
+        }
+
+        std::vector<std::string> getCousins(std::string_view person, uint32_t degree, uint32_t removed)
+        {
+            return byName(person, [&](const Version &v, KinshipSearch &s, PersonId p)
+                          { return s.cousins(*v.family, p, degree, removed); });
+        }
+
+        bool isAncestor(std::string_view ancestor, std::string_view person)
+        {
+            return read([&](const Version &v, KinshipSearch &s)
+                        {
+                            PersonId a = v.family->find(ancestor), p = v.family->find(person);
+                            return a != NO_PERSON && p != NO_PERSON && s.isAncestor(*v.family, v.index, a, p); });
+        }
+
+        // What `other` is to `person`, e.g. "first cousin once removed"
+        std::string getRelationship(std::string_view person, std::string_view other)
+        {
+            return read([&](const Version &v, KinshipSearch &s)
+                        {
+                            PersonId a = v.family->find(person), b = v.family->find(other);
+                            return describe(a == NO_PERSON || b == NO_PERSON ? Kinship{} : s.relationship(*v.family, a, b)); });
+        }
+
+        std::string getGender(std::string_view person)
+        {
+            return read([&](const Version &v, KinshipSearch &)
+                        {
+                            PersonId p = v.family->find(person);
+                            return std::string(genderName(p == NO_PERSON ? Gender::Unknown : v.family->gender(p))); });
+        }
+
+    private:
+        // Epoch pin for the outermost read() of this reader
+        struct Pin
+        {
+            Reader &reader;
+            const Version *version;
+
+            explicit Pin(Reader &reader) : reader(reader)
+            {
+                if (reader.depth++ == 0)
+                    reader.service.epochs.enter(reader.slot);
+                version = reader.service.current.load(std::memory_order_seq_cst);
+            }
+
+            ~Pin()
+            {
+                if (--reader.depth == 0)
+                    reader.service.epochs.exit(reader.slot);
+            }
+        };
+
+        FamilyService &service;
+        EpochDomain::Slot *slot;
+        KinshipSearch search;
+        int depth = 0;
+
+        template <class Relation>
+        std::vector<std::string> byName(std::string_view person, Relation relation)
+        {
+            return read([&](const Version &v, KinshipSearch &s)
+                        {
+                            std::vector<std::string> names;
+                            PersonId id = v.family->find(person);
+                            if (id == NO_PERSON)
+                                return names;
+                            for (PersonId relative : relation(v, s, id))
+                                names.emplace_back(v.family->name(relative));
+                            return names; });
+        }
+    };
+
+    FamilyService()
+    {
+        auto first = std::make_unique<Version>();
+        first->family = builder.snapshot();
+        first->index = builder.kinship();
+        current.store(first.release(), std::memory_order_seq_cst);
+    }
+
+    ~FamilyService()
+    {
+        delete current.load(std::memory_order_acquire);
+    }
+
+    FamilyService(const FamilyService &) = delete;
+    FamilyService &operator=(const FamilyService &) = delete;
+
+    // --- Writers; safe from any thread, visible after the next publish() ---
+
+    void addParent(std::string_view parent, std::string_view child)
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending.addParent(pending.intern(parent), pending.intern(child));
+    }
+
+    void addGender(std::string_view person, Gender gender)
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending.addGender(pending.intern(person), gender);
+    }
+
+    // For bulk loads (see family_loader.h)
+    void addRecords(FamilyRecords records)
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending.addRecords(std::move(records));
+    }
+
+    // Builds and publishes the next version from the pending batch; returns
+    // the number of the current version (unchanged if nothing was pending).
+    // Throws if the batch would make the parent links cyclic; the batch is
+    // then dropped and the current version stays.
+    uint64_t publish()
+    {
+        std::lock_guard<std::mutex> publishing(publishMutex);
+        const Version *previous = current.load(std::memory_order_acquire);
+        FamilyRecords batch;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            if (pending.personCount() == 0)
+                return previous->number;
+            batch = pending.release();
+        }
+        auto next = std::make_unique<Version>();
+        next->number = previous->number + 1;
+        builder.addRecords(std::move(batch));
+        next->family = builder.snapshot(); // on a cycle, drops the batch and throws
+        next->index = builder.kinship();
+        uint64_t number = next->number;
+        const Version *old = current.exchange(next.release(), std::memory_order_seq_cst);
+        epochs.retire([old]
+                      { delete old; });
+        return number;
+    }
+
+    // Retired versions that readers may still be using
+    size_t retiredVersions()
+    {
+        return epochs.collect();
+    }
+
+private:
+    EpochDomain epochs;
+    std::atomic<const Version *> current{nullptr};
+    std::mutex pendingMutex;
+    KnowledgeBase pending; // only interns and collects; never frozen
+    std::mutex publishMutex;
+    KnowledgeBase builder; // current version as a snapshot and index, and the batch being applied
+};
@@ -0,0 +1,1764 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../common/shared_chunks.h"
+
+using PersonId = uint32_t;
+constexpr PersonId NO_PERSON = std::numeric_limits<PersonId>::max();
+
+// Non-owning view of consecutive elements
+template <class T>
+class Span
+{
+public:
+    Span() = default;
+
+    Span(const T *first, const T *last) : first(first), last(last) {}
+
+    const T *begin() const
+    {
+        return first;
+    }
+
+    const T *end() const
+    {
+        return last;
+    }
+
+    size_t size() const
+    {
+        return static_cast<size_t>(last - first);
+    }
+
+    bool empty() const
+    {
+        return first == last;
+    }
+
+    const T &operator[](size_t i) const
+    {
+        return first[i];
+    }
+
+private:
+    const T *first = nullptr;
+    const T *last = nullptr;
+};
+
+// People's names interned to dense ids 0 .. size() - 1.
+// All names share one character buffer and are found through an
+// open-addressing table of ids, which takes about 20 bytes per name on top of
+// the characters, a fraction of what a hash map of strings needs.
+class NameTable
+{
+public:
+    static uint64_t hashName(std::string_view name)
+    {
+        // FNV-1a
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (unsigned char c : name)
+            hash = (hash ^ c) * 0x100000001b3ull;
+        return hash;
+    }
+
+    size_t size() const
+    {
+        return hashes.size();
+    }
+
+    // Total length of all names
+    size_t characters() const
+    {
+        return chars.size();
+    }
+
+    std::string_view name(PersonId id) const
+    {
+        return {chars.data() + offsets[id], static_cast<size_t>(offsets[id + 1] - offsets[id])};
+    }
+
+    PersonId find(std::string_view name) const
+    {
+        return find(name, hashName(name));
+    }
+
+    PersonId find(std::string_view name, uint64_t hash) const
+    {
+        if (slots.empty())
+            return NO_PERSON;
+        size_t mask = slots.size() - 1;
+        for (size_t s = hash & mask;; s = (s + 1) & mask)
+        {
+            PersonId id = slots[s];
+            if (id == NO_PERSON)
+                return NO_PERSON;
+            if (hashes[id] == static_cast<uint32_t>(hash) && this->name(id) == name)
+                return id;
+        }
+    }
+
+    // Returns the id of `name`, adding it if needed
+    PersonId insert(std::string_view name)
+    {
+        return insert(name, hashName(name));
+    }
+
+    PersonId insert(std::string_view name, uint64_t hash)
+    {
+        if ((size() + 1) * 2 > slots.size())
+            rehash(std::max<size_t>(slots.size() * 2, 16));
+        size_t mask = slots.size() - 1;
+        size_t s = hash & mask;
+        for (;; s = (s + 1) & mask)
+        {
+            PersonId id = slots[s];
+            if (id == NO_PERSON)
+                break;
+            if (hashes[id] == static_cast<uint32_t>(hash) && this->name(id) == name)
+                return id;
+        }
+        PersonId id = static_cast<PersonId>(size());
+        chars.append(name.data(), name.size());
+        offsets.push_back(chars.size());
+        hashes.push_back(static_cast<uint32_t>(hash));
+        slots[s] = id;
+        return id;
+    }
+
+    // Adds all names of `other`, none of which may be in this table yet,
+    // keeping their order and without hashing them again
+    void append(const NameTable &other)
+    {
+        size_t count = size() + other.size();
+        if (count * 2 > slots.size())
+            rehash(roundUp(count * 2));
+        size_t base = chars.size();
+        chars += other.chars;
+        offsets.reserve(count + 1);
+        for (size_t i = 1; i < other.offsets.size(); i++)
+            offsets.push_back(base + other.offsets[i]);
+        size_t mask = slots.size() - 1;
+        for (uint32_t hash : other.hashes)
+        {
+            size_t s = hash & mask;
+            while (slots[s] != NO_PERSON)
+                s = (s + 1) & mask;
+            slots[s] = static_cast<PersonId>(hashes.size());
+            hashes.push_back(hash);
+        }
+    }
+
+    void reserve(size_t names, size_t characters)
+    {
+        chars.reserve(characters);
+        offsets.reserve(names + 1);
+        hashes.reserve(names);
+        if (names * 2 > slots.size())
+            rehash(roundUp(names * 2));
+    }
+
+private:
+    std::string chars;
+    std::vector<uint64_t> offsets{0}; // name of id i is chars[offsets[i] .. offsets[i + 1])
+    std::vector<uint32_t> hashes;     // low half of each name's hash
+    std::vector<PersonId> slots;      // ids, NO_PERSON for free slots; the size is a power of 2
+
+    static size_t roundUp(size_t n)
+    {
+        size_t size = 16;
+        while (size < n)
+            size *= 2;
+        return size;
+    }
+
+    // Slots are chosen by the low bits of the hash, which are all kept
+    void rehash(size_t slotCount)
+    {
+        slots.assign(slotCount, NO_PERSON);
+        size_t mask = slotCount - 1;
+        for (PersonId id = 0; id < hashes.size(); id++)
+        {
+            size_t s = hashes[id] & mask;
+            while (slots[s] != NO_PERSON)
+                s = (s + 1) & mask;
+            slots[s] = id;
+        }
+    }
+};
+
+enum class Gender : uint8_t
+{
+    Unknown,
+    Male,
+    Female,
+    Other
+};
+
+// "M", "male", "Female", ... ; empty, "U" and "Unknown" are Unknown and
+// anything else is Other
+inline Gender parseGender(std::string_view text)
+{
+    auto is = [&](const char *word)
+    {
+        size_t length = std::strlen(word);
+        if (text.size() != length && text.size() != 1)
+            return false;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            if (std::tolower(static_cast<unsigned char>(text[i])) != word[i])
+                return false;
+        }
+        return true;
+    };
+    if (text.empty() || is("unknown"))
+        return Gender::Unknown;
+    if (is("male"))
+        return Gender::Male;
+    if (is("female"))
+        return Gender::Female;
+    return Gender::Other;
+}
+
+inline const char *genderName(Gender gender)
+{
+    switch (gender)
+    {
+    case Gender::Male:
+        return "Male";
+    case Gender::Female:
+        return "Female";
+    case Gender::Other:
+        return "Other";
+    default:
+        return "Unknown";
+    }
+}
+
+// Plain storage for people and parent -> child links over interned ids.
+// Link i says that linkParent[i] is a parent of linkChild[i].
+struct FamilyRecords
+{
+    NameTable names;
+    std::vector<Gender> genders;
+    std::vector<PersonId> linkParent;
+    std::vector<PersonId> linkChild;
+};
+
+// What to add to a family snapshot: new people, whose ids follow those of the
+// people already in it, with their names and genders in `added`; links in
+// `added` between any of the people, old or new; and new genders of people
+// already in it.
+struct FamilyChanges
+{
+    FamilyRecords added;
+    std::vector<std::pair<PersonId, Gender>> genders;
+};
+
+// A list of people for every person, such as everyone's children, as CSR
+// arrays in blocks of BLOCK people. A block is one array: BLOCK + 1 list
+// starts, then the lists, so the list of p is
+// lists[start[p % BLOCK] .. start[p % BLOCK + 1]) of block p / BLOCK and
+// costs no more memory accesses than with a single CSR array.
+// Copies share their blocks, and add() replaces only the blocks it changes.
+class PersonLists
+{
+public:
+    static constexpr unsigned SHIFT = 10;
+    static constexpr size_t BLOCK = size_t(1) << SHIFT;
+
+    Span<PersonId> operator[](PersonId person) const
+    {
+        const uint32_t *block = data[person >> SHIFT];
+        const uint32_t *start = block + (person & (BLOCK - 1));
+        const PersonId *lists = block + BLOCK + 1;
+        return {lists + start[0], lists + start[1]};
+    }
+
+    // Entries in all lists
+    size_t total() const
+    {
+        return entries;
+    }
+
+    // Makes room for `people` people, then appends to[i] to the list of
+    // from[i] for every i in order, unless that list already has it
+    void add(size_t people, const std::vector<PersonId> &from, const std::vector<PersonId> &to)
+    {
+        size_t blockCount = (people + BLOCK - 1) >> SHIFT;
+        if (blocks.size() < blockCount)
+        {
+            blocks.resize(blockCount, emptyBlock());
+            data.resize(blockCount, emptyBlock().get());
+        }
+
+        // Counting sort of the entries by block, in order within each block
+        std::vector<uint32_t> blockStart(blockCount + 1, 0);
+        for (PersonId p : from)
+            blockStart[(p >> SHIFT) + 1]++;
+        for (size_t b = 0; b < blockCount; b++)
+            blockStart[b + 1] += blockStart[b];
+        std::vector<uint32_t> order(from.size());
+        std::vector<uint32_t> fill(blockStart.begin(), blockStart.end() - 1);
+        for (uint32_t i = 0; i < from.size(); i++)
+            order[fill[from[i] >> SHIFT]++] = i;
+
+        for (size_t b = 0; b < blockCount; b++)
+        {
+            if (blockStart[b] == blockStart[b + 1])
+                continue;
+            Block merged = merge(data[b], from, to, order.data() + blockStart[b], order.data() + blockStart[b + 1]);
+            entries += merged.get()[BLOCK] - data[b][BLOCK];
+            blocks[b] = std::move(merged);
+            data[b] = blocks[b].get();
+        }
+    }
+
+private:
+    using Block = std::shared_ptr<const uint32_t[]>;
+
+    std::vector<Block> blocks;
+    std::vector<const uint32_t *> data; // blocks[b].get(), half the size for reads
+    size_t entries = 0;
+
+    // Shared by all blocks of people with empty lists
+    static const Block &emptyBlock()
+    {
+        static const Block empty(new uint32_t[BLOCK + 1]());
+        return empty;
+    }
+
+    // `old` with the entries order[first .. last) added
+    static Block merge(const uint32_t *old, const std::vector<PersonId> &from, const std::vector<PersonId> &to,
+                       const uint32_t *first, const uint32_t *last)
+    {
+        const PersonId *oldLists = old + BLOCK + 1;
+        std::vector<uint32_t> newStart(BLOCK + 1, 0);
+        for (const uint32_t *i = first; i != last; i++)
+            newStart[(from[*i] & (BLOCK - 1)) + 1]++;
+        for (size_t p = 0; p < BLOCK; p++)
+            newStart[p + 1] += newStart[p];
+        std::vector<PersonId> newList(last - first);
+        std::vector<uint32_t> fill(newStart.begin(), newStart.end() - 1);
+        for (const uint32_t *i = first; i != last; i++)
+            newList[fill[from[*i] & (BLOCK - 1)]++] = to[*i];
+
+        std::vector<uint32_t> start(BLOCK + 1);
+        std::vector<PersonId> list;
+        list.reserve(old[BLOCK] + newList.size());
+        std::unordered_set<PersonId> seen;
+        for (size_t p = 0; p < BLOCK; p++)
+        {
+            uint32_t begin = static_cast<uint32_t>(list.size());
+            start[p] = begin;
+            list.insert(list.end(), oldLists + old[p], oldLists + old[p + 1]);
+            if (newStart[p] == newStart[p + 1])
+                continue;
+            // Short lists are searched; long ones get a hash set
+            bool hashed = list.size() - begin + (newStart[p + 1] - newStart[p]) > 64;
+            if (hashed)
+            {
+                seen.clear();
+                seen.insert(list.begin() + begin, list.end());
+            }
+            for (uint32_t i = newStart[p]; i < newStart[p + 1]; i++)
+            {
+                PersonId other = newList[i];
+                bool repeated = hashed ? !seen.insert(other).second
+                                       : std::find(list.begin() + begin, list.end(), other) != list.end();
+                if (!repeated)
+                    list.push_back(other);
+            }
+        }
+        start[BLOCK] = static_cast<uint32_t>(list.size());
+        std::unique_ptr<uint32_t[]> block(new uint32_t[BLOCK + 1 + list.size()]);
+        std::copy(start.begin(), start.end(), block.get());
+        std::copy(list.begin(), list.end(), block.get() + BLOCK + 1);
+        return Block(std::move(block));
+    }
+};
+
+// Immutable, shareable view of the family records.
+// Children and parents are kept in two PersonLists, so both directions are
+// read in O(output) with no hashing. Nothing changes after construction, so
+// any number of threads can query one snapshot.
+//
+// A snapshot made from a previous one plus changes shares everything the
+// changes leave alone with it: blocks of lists, chunks of genders (see
+// SharedChunks) and name tables. It costs O(people / PersonLists::BLOCK)
+// plus the blocks and chunks that change, not a copy of all records. Names
+// are kept in a few tables. The names of new people form a new last table,
+// which is merged into the one before while it is more than half that size,
+// so over all snapshots each name is copied O(log people) times.
+class FamilySnapshot
+{
+public:
+    // No people
+    FamilySnapshot() = default;
+
+    explicit FamilySnapshot(FamilyRecords records) : FamilySnapshot(FamilySnapshot(), FamilyChanges{std::move(records), {}})
+    {
+    }
+
+    // `previous` plus `changes`
+    FamilySnapshot(const FamilySnapshot &previous, FamilyChanges changes)
+        : nameTables(previous.nameTables), firstIds(previous.firstIds), genders(previous.genders),
+          childLists(previous.childLists), parentLists(previous.parentLists), history(previous.history)
+    {
+        FamilyRecords &added = changes.added;
+        size_t people = previous.personCount() + added.names.size();
+        if (added.names.size() > 0)
+            addNames(static_cast<PersonId>(previous.personCount()), std::move(added.names));
+        genders.resize(people);
+        for (size_t i = 0; i < added.genders.size(); i++)
+            genders.at(previous.personCount() + i) = added.genders[i];
+        for (const auto &change : changes.genders)
+            genders.at(change.first) = change.second;
+        childLists.add(people, added.linkParent, added.linkChild);
+        parentLists.add(people, added.linkChild, added.linkParent);
+        history += added.linkParent.size();
+        addedParents = std::move(added.linkParent);
+        addedChildren = std::move(added.linkChild);
+    }
+
+    size_t personCount() const
+    {
+        return genders.size();
+    }
+
+    // Number of distinct parent -> child links
+    size_t linkCount() const
+    {
+        return childLists.total();
+    }
+
+    // Links added up to this snapshot, counting repeats
+    size_t linkHistory() const
+    {
+        return history;
+    }
+
+    // The links this snapshot added, in order: all of them for a snapshot
+    // made from records, only the changes for one made from a previous one
+    Span<PersonId> newParents() const
+    {
+        return {addedParents.data(), addedParents.data() + addedParents.size()};
+    }
+
+    Span<PersonId> newChildren() const
+    {
+        return {addedChildren.data(), addedChildren.data() + addedChildren.size()};
+    }
+
+    PersonId find(std::string_view name) const
+    {
+        return find(name, NameTable::hashName(name));
+    }
+
+    PersonId find(std::string_view name, uint64_t hash) const
+    {
+        for (size_t t = 0; t < nameTables.size(); t++)
+        {
+            PersonId id = nameTables[t]->find(name, hash);
+            if (id != NO_PERSON)
+                return firstIds[t] + id;
+        }
+        return NO_PERSON;
+    }
+
+    std::string_view name(PersonId person) const
+    {
+        size_t t = nameTables.size() - 1;
+        while (firstIds[t] > person)
+            t--;
+        return nameTables[t]->name(person - firstIds[t]);
+    }
+
+    Gender gender(PersonId person) const
+    {
+        return genders[person];
+    }
+
+    // In the order the links were added
+    Span<PersonId> children(PersonId person) const
+    {
+        return childLists[person];
+    }
+
+    Span<PersonId> parents(PersonId person) const
+    {
+        return parentLists[person];
+    }
+
+    // A copy of the records, with each distinct link once
+    FamilyRecords records() const
+    {
+        FamilyRecords records;
+        for (const auto &table : nameTables)
+            records.names.append(*table);
+        records.genders.reserve(personCount());
+        for (PersonId p = 0; p < personCount(); p++)
+            records.genders.push_back(genders[p]);
+        records.linkParent.reserve(linkCount());
+        records.linkChild.reserve(linkCount());
+        for (PersonId p = 0; p < personCount(); p++)
+        {
+            for (PersonId child : children(p))
+            {
+                records.linkParent.push_back(p);
+                records.linkChild.push_back(child);
+            }
+        }
+        return records;
+    }
+
+private:
+    std::vector<std::shared_ptr<const NameTable>> nameTables;
+    std::vector<PersonId> firstIds; // id of the first name of each table
+    SharedChunks<Gender> genders;
+    PersonLists childLists;
+    PersonLists parentLists;
+    size_t history = 0;
+    std::vector<PersonId> addedParents;
+    std::vector<PersonId> addedChildren;
+
+    void addNames(PersonId firstId, NameTable names)
+    {
+        firstIds.push_back(firstId);
+        nameTables.push_back(std::make_shared<const NameTable>(std::move(names)));
+        while (nameTables.size() > 1 && nameTables.back()->size() * 2 > nameTables[nameTables.size() - 2]->size())
+        {
+            auto merged = std::make_shared<NameTable>(*nameTables[nameTables.size() - 2]);
+            merged->append(*nameTables.back());
+            nameTables.pop_back();
+            firstIds.pop_back();
+            nameTables.back() = std::move(merged);
+        }
+    }
+};
+
+// A set of people that is emptied in O(1): entries are stamped with the
+// current round and never cleared, only outdated by the next reset()
+class PersonMarks
+{
+public:
+    // Empties the set, for ids below `people`
+    void reset(size_t people)
+    {
+        if (stamps.size() < people)
+            stamps.resize(people, 0);
+        if (++stamp == 0)
+        {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            stamp = 1;
+        }
+    }
+
+    bool contains(PersonId person) const
+    {
+        return stamps[person] == stamp;
+    }
+
+    // True if `person` was not in the set yet
+    bool insert(PersonId person)
+    {
+        if (stamps[person] == stamp)
+            return false;
+        stamps[person] = stamp;
+        return true;
+    }
+
+private:
+    std::vector<uint32_t> stamps;
+    uint32_t stamp = 0;
+};
+
+// Precomputed data that bounds kinship searches on a family snapshot.
+//
+// generation(p) is 0 for people without recorded parents and otherwise one
+// more than the latest generation among the parents. Every parent link goes
+// back at least one generation, so an ancestor of p is always in an earlier
+// generation, and an ancestor k links up is at least k generations earlier.
+//
+// With two parents per person the ancestors k links up can be 2^k people, so
+// jump tables (binary lifting, level ancestors) do not apply: they need one
+// k-th ancestor per person, which only a tree has. Two other labels bound
+// ancestor searches instead:
+//
+// - Reachability intervals (as in GRAIL): a depth-first walk down from the
+//   people without parents numbers everyone in post-order, and each person's
+//   interval runs from the lowest number among their descendants to their
+//   own. A descendant's interval always lies inside the ancestor's, so when
+//   it does not, the answer is no, at any distance. INTERVALS walks with
+//   opposite child orders make false candidates rare.
+// - A 128-bit Bloom signature of the ancestors at most NEAR_STEPS links up,
+//   which is sharper than the intervals close to the person looked for.
+//
+// update() only processes the people and links added since the snapshot it
+// saw last: new people get empty intervals, which every interval contains,
+// and a new link widens the intervals of the parent and of its ancestors
+// until they contain the child's again. Adding children therefore costs
+// nothing, and only a link to someone who already has descendants walks up.
+// Widened intervals stay correct but prune less, which a rebuild fixes; it
+// happens when the snapshot does not follow the last one or too much has
+// changed.
+//
+// Generations and the labels of each person are kept in SharedChunks, so a
+// copy of the index shares them until one side updates, and an update copies
+// only the chunks it changes. The working memory of updates is kept apart, in
+// a Scratch.
+class KinshipIndex
+{
+public:
+    static constexpr int NEAR_STEPS = 4;
+    static constexpr int INTERVALS = 2;
+
+    // Working memory for update(); one per writer
+    struct Scratch
+    {
+        PersonMarks changed;
+        std::vector<PersonId> changedList;
+        PersonMarks visited;
+        std::vector<PersonId> level;
+        std::vector<PersonId> next;
+    };
+
+    void update(const FamilySnapshot &family, Scratch &scratch)
+    {
+        size_t people = family.personCount(), links = family.linkHistory();
+        Span<PersonId> parents = family.newParents(), children = family.newChildren();
+        if (generations.empty() || people < generations.size() || links - parents.size() != linksSeen ||
+            parents.size() * 8 > links)
+        {
+            rebuild(family, scratch);
+            return;
+        }
+
+        generations.resize(people, 0);
+        labels.resize(people, Labels{});
+        scratch.changed.reset(people);
+        scratch.changedList.clear();
+        for (size_t i = 0; i < parents.size(); i++)
+        {
+            addLink(family, scratch, parents[i], children[i]);
+            widen(family, scratch, parents[i], children[i]);
+        }
+        linksSeen = links;
+
+        // A signature covers NEAR_STEPS links up, so the new links change the
+        // signatures of their children and of the descendants of those
+        // children, up to NEAR_STEPS - 1 links down
+        std::vector<PersonId> &changedList = scratch.changedList;
+        std::vector<PersonId> level(changedList), next;
+        for (int step = 1; step < NEAR_STEPS && !level.empty(); step++)
+        {
+            next.clear();
+            for (PersonId p : level)
+            {
+                for (PersonId child : family.children(p))
+                {
+                    if (scratch.changed.insert(child))
+                    {
+                        changedList.push_back(child);
+                        next.push_back(child);
+                    }
+                }
+            }
+            level.swap(next);
+        }
+        for (PersonId p : changedList)
+            computeSignature(family, scratch, p);
+    }
+
+    size_t personCount() const
+    {
+        return generations.size();
+    }
+
+    uint32_t generation(PersonId person) const
+    {
+        return generations[person];
+    }
+
+    // False if `ancestor` is certainly not among the ancestors of `person` at
+    // most NEAR_STEPS links up
+    bool mayBeNearAncestor(PersonId ancestor, PersonId person) const
+    {
+        uint32_t bit = signatureBit(ancestor);
+        return (labels[person].signature.words[bit / 64] >> (bit % 64)) & 1;
+    }
+
+    // False if `ancestor` is certainly not an ancestor of `person`, or the
+    // person themselves, at any distance
+    bool mayBeAncestor(PersonId ancestor, PersonId person) const
+    {
+        const Intervals &a = labels[ancestor].intervals, &p = labels[person].intervals;
+        for (int i = 0; i < INTERVALS; i++)
+        {
+            if (p.low[i] < a.low[i] || p.high[i] > a.high[i])
+                return false;
+        }
+        return true;
+    }
+
+private:
+    struct Signature
+    {
+        uint64_t words[2] = {0, 0};
+    };
+
+    // One interval [low, high] per walk; empty until numbered
+    struct Intervals
+    {
+        uint32_t low[INTERVALS] = {UINT32_MAX, UINT32_MAX};
+        uint32_t high[INTERVALS] = {0, 0};
+    };
+
+    // Read together by ancestor searches; aligned to half a cache line
+    struct alignas(32) Labels
+    {
+        Signature signature;
+        Intervals intervals;
+    };
+
+    SharedChunks<uint32_t, 12> generations;
+    SharedChunks<Labels> labels;
+    size_t linksSeen = 0;
+
+    static uint32_t signatureBit(PersonId person)
+    {
+        return static_cast<uint32_t>((person * 0x9E3779B97F4A7C15ull) >> 57);
+    }
+
+    // Generations in topological order (Kahn's algorithm), then all signatures
+    // and intervals
+    void rebuild(const FamilySnapshot &family, Scratch &scratch)
+    {
+        size_t people = family.personCount();
+        generations.assign(people, 0);
+        labels.assign(people, Labels{});
+        linksSeen = 0;
+        std::vector<uint32_t> waiting(people);
+        std::vector<PersonId> ready;
+        for (PersonId p = 0; p < people; p++)
+        {
+            waiting[p] = static_cast<uint32_t>(family.parents(p).size());
+            if (waiting[p] == 0)
+                ready.push_back(p);
+        }
+        size_t done = 0;
+        while (!ready.empty())
+        {
+            PersonId p = ready.back();
+            ready.pop_back();
+            done++;
+            for (PersonId child : family.children(p))
+            {
+                generations.at(child) = std::max(generations[child], generations[p] + 1);
+                if (--waiting[child] == 0)
+                    ready.push_back(child);
+            }
+        }
+        if (done < people)
+        {
+            generations.clear();
+            throw std::runtime_error("the parent links contain a cycle");
+        }
+        for (PersonId p = 0; p < people; p++)
+            computeSignature(family, scratch, p);
+        computeIntervals(family, scratch);
+        linksSeen = family.linkHistory();
+    }
+
+    // Numbers everyone in post-order of depth-first walks down from the
+    // people without parents; walk i takes the roots and children in
+    // order for even i and in reverse for odd i. The intervals start empty.
+    void computeIntervals(const FamilySnapshot &family, Scratch &scratch)
+    {
+        size_t people = family.personCount();
+        struct Visit
+        {
+            PersonId person;
+            uint32_t next; // children taken so far
+        };
+        std::vector<Visit> stack;
+        for (int walk = 0; walk < INTERVALS; walk++)
+        {
+            bool reverse = walk % 2 == 1;
+            uint32_t number = 0;
+            scratch.visited.reset(people);
+            for (size_t i = 0; i < people; i++)
+            {
+                PersonId root = static_cast<PersonId>(reverse ? people - 1 - i : i);
+                if (!family.parents(root).empty() || !scratch.visited.insert(root))
+                    continue;
+                labels.at(root).intervals.low[walk] = UINT32_MAX;
+                stack.assign(1, Visit{root, 0});
+                while (!stack.empty())
+                {
+                    Visit &top = stack.back();
+                    Span<PersonId> children = family.children(top.person);
+                    if (top.next < children.size())
+                    {
+                        PersonId child = children[reverse ? children.size() - 1 - top.next : top.next];
+                        top.next++;
+                        if (scratch.visited.insert(child))
+                        {
+                            labels.at(child).intervals.low[walk] = UINT32_MAX;
+                            stack.push_back(Visit{child, 0});
+                        }
+                        else
+                        {
+                            // Already numbered: its lowest descendant is one of ours
+                            uint32_t &low = labels.at(top.person).intervals.low[walk];
+                            low = std::min(low, labels[child].intervals.low[walk]);
+                        }
+                        continue;
+                    }
+                    Intervals &own = labels.at(top.person).intervals;
+                    own.high[walk] = number;
+                    own.low[walk] = std::min(own.low[walk], number);
+                    number++;
+                    PersonId done = top.person;
+                    stack.pop_back();
+                    if (!stack.empty())
+                    {
+                        uint32_t &low = labels.at(stack.back().person).intervals.low[walk];
+                        low = std::min(low, labels[done].intervals.low[walk]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Makes the intervals of `parent` and of its ancestors contain the
+    // interval of `child` again after a new link
+    void widen(const FamilySnapshot &family, Scratch &scratch, PersonId parent, PersonId child)
+    {
+        std::vector<PersonId> &level = scratch.level;
+        level.clear();
+        if (absorb(parent, child))
+            level.push_back(parent);
+        while (!level.empty())
+        {
+            PersonId p = level.back();
+            level.pop_back();
+            for (PersonId grandparent : family.parents(p))
+            {
+                if (absorb(grandparent, p))
+                    level.push_back(grandparent);
+            }
+        }
+    }
+
+    // Widens the intervals of `outer` to contain those of `inner`; true if
+    // they changed
+    bool absorb(PersonId outer, PersonId inner)
+    {
+        const Intervals &o = labels[outer].intervals, &in = labels[inner].intervals;
+        bool grows = false;
+        for (int i = 0; i < INTERVALS; i++)
+            grows = grows || in.low[i] < o.low[i] || in.high[i] > o.high[i];
+        if (!grows)
+            return false;
+        Intervals widened = o;
+        for (int i = 0; i < INTERVALS; i++)
+        {
+            widened.low[i] = std::min(widened.low[i], in.low[i]);
+            widened.high[i] = std::max(widened.high[i], in.high[i]);
+        }
+        labels.at(outer).intervals = widened;
+        return true;
+    }
+
+    // Moves `child` and its descendants to later generations where the new
+    // link requires it
+    void addLink(const FamilySnapshot &family, Scratch &scratch, PersonId parent, PersonId child)
+    {
+        if (scratch.changed.insert(child))
+            scratch.changedList.push_back(child);
+        if (generations[parent] < generations[child])
+            return;
+        std::vector<PersonId> &level = scratch.level;
+        level.assign(1, child);
+        generations.at(child) = generations[parent] + 1;
+        while (!level.empty())
+        {
+            PersonId p = level.back();
+            level.pop_back();
+            if (p == parent)
+            {
+                generations.clear();
+                throw std::runtime_error("the parent links contain a cycle");
+            }
+            for (PersonId c : family.children(p))
+            {
+                if (generations[c] <= generations[p])
+                {
+                    generations.at(c) = generations[p] + 1;
+                    level.push_back(c);
+                }
+            }
+        }
+    }
+
+    void computeSignature(const FamilySnapshot &family, Scratch &scratch, PersonId person)
+    {
+        Signature signature;
+        std::vector<PersonId> &level = scratch.level, &next = scratch.next;
+        scratch.visited.reset(family.personCount());
+        level.assign(1, person);
+        for (int step = 1; step <= NEAR_STEPS && !level.empty(); step++)
+        {
+            next.clear();
+            for (PersonId p : level)
+            {
+                for (PersonId parent : family.parents(p))
+                {
+                    if (scratch.visited.insert(parent))
+                    {
+                        uint32_t bit = signatureBit(parent);
+                        signature.words[bit / 64] |= uint64_t(1) << (bit % 64);
+                        next.push_back(parent);
+                    }
+                }
+            }
+            level.swap(next);
+        }
+        labels.at(person).signature = signature;
+    }
+};
+
+// How two people are related through their nearest common ancestor, who is
+// `up` links above the first person and `down` links above the second one
+struct Kinship
+{
+    PersonId ancestor = NO_PERSON; // NO_PERSON if no common ancestor was found
+    uint32_t up = 0;
+    uint32_t down = 0;
+
+    bool related() const
+    {
+        return ancestor != NO_PERSON;
+    }
+
+    // 0 for siblings (and uncles, nephews, ...), 1 for first cousins, and so
+    // on; -1 if one of them is an ancestor of the other
+    int degree() const
+    {
+        return static_cast<int>(std::min(up, down)) - 1;
+    }
+
+    // Generations between the two
+    int removed() const
+    {
+        return static_cast<int>(up > down ? up - down : down - up);
+    }
+};
+
+// What the second person is to the first one, such as "grandparent" or
+// "second cousin once removed"
+inline std::string describe(const Kinship &kinship)
+{
+    static const char *const ordinals[] = {"", "first", "second", "third", "fourth", "fifth", "sixth", "seventh", "eighth", "ninth", "tenth"};
+    static const char *const times[] = {"", "once", "twice", "three times"};
+    auto ordinal = [&](int n)
+    { return n <= 10 ? std::string(ordinals[n]) : std::to_string(n) + "th"; };
+    auto greats = [](int n)
+    {
+        std::string prefix;
+        for (int i = 0; i < n; i++)
+            prefix += "great-";
+        return prefix;
+    };
+    if (!kinship.related())
+        return "not related";
+    int up = static_cast<int>(kinship.up), down = static_cast<int>(kinship.down);
+    if (up == 0 && down == 0)
+        return "same person";
+    if (down == 0)
+        return up == 1 ? "parent" : greats(up - 2) + "grandparent";
+    if (up == 0)
+        return down == 1 ? "child" : greats(down - 2) + "grandchild";
+    if (up == 1 && down == 1)
+        return "sibling";
+    if (down == 1)
+        return greats(up - 2) + "uncle/aunt";
+    if (up == 1)
+        return greats(down - 2) + "nephew/niece";
+    int removed = kinship.removed();
+    std::string name = ordinal(kinship.degree()) + " cousin";
+    if (removed > 0)
+        name += " " + (removed < 4 ? std::string(times[removed]) : std::to_string(removed) + " times") + " removed";
+    return name;
+}
+
+// Kinship queries on one snapshot, with scratch buffers reused across queries.
+// Each result is collected without repeats in a buffer owned by the search,
+// so the returned span is valid until its next query, and a query costs
+// O(people visited) with no allocation once the buffers have grown.
+// Use one per thread.
+class KinshipSearch
+{
+public:
+    Span<PersonId> grandparents(const FamilySnapshot &family, PersonId person)
+    {
+        start(family);
+        for (PersonId parent : family.parents(person))
+        {
+            for (PersonId grandparent : family.parents(parent))
+                add(grandparent);
+        }
+        return finish();
+    }
+
+    // Full and half siblings
+    Span<PersonId> siblings(const FamilySnapshot &family, PersonId person)
+    {
+        start(family);
+        marks.insert(person);
+        addSiblings(family, person);
+        return finish();
+    }
+
+    // Siblings of the parents
+    Span<PersonId> unclesAunts(const FamilySnapshot &family, PersonId person)
+    {
+        start(family);
+        // A parent is never its own child's uncle, even if the records say
+        // the parents are siblings
+        for (PersonId parent : family.parents(person))
+            marks.insert(parent);
+        for (PersonId parent : family.parents(person))
+            addSiblings(family, parent);
+        return finish();
+    }
+
+    // Children of the siblings
+    Span<PersonId> nephewsNieces(const FamilySnapshot &family, PersonId person)
+    {
+        start(family);
+        level.clear();
+        marks.insert(person);
+        for (PersonId parent : family.parents(person))
+        {
+            for (PersonId sibling : family.children(parent))
+            {
+                if (marks.insert(sibling))
+                    level.push_back(sibling);
+            }
+        }
+        // Siblings were only marked to skip repeats among them; a new round
+        // lets a sibling's child appear even if it is also a sibling
+        marks.reset(family.personCount());
+        marks.insert(person);
+        for (PersonId sibling : level)
+        {
+            for (PersonId child : family.children(sibling))
+                add(child);
+        }
+        return finish();
+    }
+
+    // Whether `ancestor` is a parent, grandparent, ... of `person`.
+    // Searches up from `person` through earlier generations only, skipping
+    // parents whose reachability intervals rule `ancestor` out and checking
+    // the near-ancestor signatures in the last NEAR_STEPS generations.
+    bool isAncestor(const FamilySnapshot &family, const KinshipIndex &index, PersonId ancestor, PersonId person)
+    {
+        uint32_t target = index.generation(ancestor);
+        if (index.generation(person) <= target || !index.mayBeAncestor(ancestor, person))
+            return false;
+        marks.reset(family.personCount());
+        level.assign(1, person);
+        while (!level.empty())
+        {
+            PersonId p = level.back();
+            level.pop_back();
+            for (PersonId parent : family.parents(p))
+            {
+                if (parent == ancestor)
+                    return true;
+                uint32_t gap = index.generation(parent) - target;
+                if (index.generation(parent) <= target || !index.mayBeAncestor(ancestor, parent) ||
+                    (gap <= KinshipIndex::NEAR_STEPS && !index.mayBeNearAncestor(ancestor, parent)))
+                    continue;
+                if (marks.insert(parent))
+                    level.push_back(parent);
+            }
+        }
+        return false;
+    }
+
+    // Everyone exactly `steps` parent links above `person`
+    Span<PersonId> ancestorsAt(const FamilySnapshot &family, const KinshipIndex &index, PersonId person, uint32_t steps)
+    {
+        start(family);
+        level.assign(1, person);
+        for (uint32_t step = 1; step <= steps && !level.empty(); step++)
+        {
+            // Someone who still has to go up steps - step links cannot be
+            // in an earlier generation than that
+            uint32_t remaining = steps - step;
+            marks.reset(family.personCount());
+            next.clear();
+            for (PersonId p : level)
+            {
+                for (PersonId parent : family.parents(p))
+                {
+                    if (index.generation(parent) >= remaining && marks.insert(parent))
+                        next.push_back(parent);
+                }
+            }
+            level.swap(next);
+        }
+        result.assign(level.begin(), level.end());
+        return finish();
+    }
+
+    // Everyone exactly `steps` child links below `person`
+    Span<PersonId> descendantsAt(const FamilySnapshot &family, PersonId person, uint32_t steps)
+    {
+        start(family);
+        descend(family, person, steps);
+        result.assign(level.begin(), level.end());
+        return finish();
+    }
+
+    // The nearest common ancestor of `first` and `second`: the one with the
+    // fewest links up from both together, then the most even split. One of
+    // them is itself the common ancestor if it is an ancestor of the other.
+    // The search goes up one generation at a time from both sides and stops
+    // once no unexplored ancestor can be nearer, or at `maxSteps` links up.
+    Kinship relationship(const FamilySnapshot &family, PersonId first, PersonId second, uint32_t maxSteps = 16)
+    {
+        nearestCommonAncestors(family, first, second, maxSteps);
+        return best;
+    }
+
+    // All common ancestors as near as the one relationship() returns
+    Span<PersonId> nearestCommonAncestors(const FamilySnapshot &family, PersonId first, PersonId second,
+                                          uint32_t maxSteps = 16)
+    {
+        best = Kinship{};
+        common.clear();
+        if (first == second)
+        {
+            best.ancestor = first;
+            common.push_back(first);
+            return {common.data(), common.data() + common.size()};
+        }
+        // Side 0 goes up from `first`, side 1 from `second`; steps[s][p] is
+        // the number of links from that side's person up to p
+        PersonId starts[2] = {first, second};
+        uint32_t levels[2] = {0, 0};
+        for (int s = 0; s < 2; s++)
+        {
+            seen[s].reset(family.personCount());
+            if (steps[s].size() < family.personCount())
+                steps[s].resize(family.personCount());
+            seen[s].insert(starts[s]);
+            steps[s][starts[s]] = 0;
+            frontiers[s].assign(1, starts[s]);
+        }
+
+        for (;;)
+        {
+            // A person that one side has not reached yet is more than that
+            // side's level up from it, so a side is done once its level
+            // reaches the total of the best common ancestor so far
+            bool done[2];
+            for (int s = 0; s < 2; s++)
+                done[s] = frontiers[s].empty() || levels[s] >= maxSteps ||
+                          (best.related() && levels[s] >= best.up + best.down);
+            if (done[0] && done[1])
+                break;
+            int s = done[0] ? 1 : done[1] ? 0 : levels[0] <= levels[1] ? 0 : 1;
+            int o = 1 - s;
+            levels[s]++;
+            next.clear();
+            for (PersonId p : frontiers[s])
+            {
+                for (PersonId parent : family.parents(p))
+                {
+                    if (!seen[s].insert(parent))
+                        continue;
+                    steps[s][parent] = levels[s];
+                    next.push_back(parent);
+                    if (seen[o].contains(parent))
+                        offer(parent, steps[0][parent], steps[1][parent]);
+                }
+            }
+            frontiers[s].swap(next);
+        }
+        return {common.data(), common.data() + common.size()};
+    }
+
+    // Everyone whose relationship() to `person` is `degree` cousin removed
+    // `removed` times, in either direction; degree 0 gives siblings
+    // (removed 0) and uncles/aunts and nephews/nieces (removed 1).
+    //
+    // Such a relative is a descendant of an ancestor of `person` at
+    // total = 2 * (degree + 1) + removed links up and down together, with
+    // no nearer common ancestor. One pass finds them all: it goes up from
+    // `person`, then down from every ancestor a, starting at a's distance
+    // up. People are taken in order of the links from `person` to them, so
+    // each one is first reached over the fewest links, by way of their
+    // nearest common ancestors; along the way it keeps how evenly the best
+    // of those splits the total.
+    Span<PersonId> cousins(const FamilySnapshot &family, PersonId person, uint32_t degree, uint32_t removed)
+    {
+        start(family);
+        uint32_t total = 2 * (degree + 1) + removed;
+        size_t people = family.personCount();
+        if (links.size() < people)
+        {
+            links.resize(people);
+            uneven.resize(people);
+        }
+        if (waves.size() < total + 1)
+            waves.resize(total + 1);
+        for (std::vector<Arrival> &wave : waves)
+            wave.clear();
+        // An ancestor u links up splits the total unevenly by |2u - total|
+        auto split = [&](uint32_t up)
+        { return 2 * up > total ? 2 * up - total : total - 2 * up; };
+
+        // Ancestors within `total` links up, each arriving at its own distance
+        seen[0].reset(people);
+        seen[0].insert(person);
+        level.assign(1, person);
+        waves[0].push_back(Arrival{person, split(0)});
+        for (uint32_t up = 1; up <= total && !level.empty(); up++)
+        {
+            next.clear();
+            for (PersonId p : level)
+            {
+                for (PersonId parent : family.parents(p))
+                {
+                    if (seen[0].insert(parent))
+                    {
+                        next.push_back(parent);
+                        waves[up].push_back(Arrival{parent, split(up)});
+                    }
+                }
+            }
+            level.swap(next);
+        }
+
+        // Down in order of links from `person`; seen[1] holds everyone reached
+        seen[1].reset(people);
+        for (uint32_t t = 0; t <= total; t++)
+        {
+            level.clear();
+            for (const Arrival &a : waves[t])
+            {
+                if (seen[1].insert(a.person))
+                {
+                    links[a.person] = t;
+                    uneven[a.person] = a.uneven;
+                    level.push_back(a.person);
+                }
+                else if (links[a.person] == t)
+                {
+                    uneven[a.person] = std::min(uneven[a.person], a.uneven);
+                }
+            }
+            for (PersonId p : level)
+            {
+                if (t == total)
+                {
+                    if (uneven[p] == removed && p != person)
+                        result.push_back(p);
+                    continue;
+                }
+                for (PersonId child : family.children(p))
+                {
+                    if (!seen[1].contains(child))
+                        waves[t + 1].push_back(Arrival{child, uneven[p]});
+                }
+            }
+        }
+        return finish();
+    }
+
+private:
+    PersonMarks marks;
+    std::vector<PersonId> result;
+    std::vector<PersonId> level;
+    std::vector<PersonId> next;
+    // relationship()
+    PersonMarks seen[2];
+    std::vector<uint32_t> steps[2];
+    std::vector<PersonId> frontiers[2];
+    std::vector<PersonId> common;
+    Kinship best;
+    // cousins(); links and uneven are valid for people in seen[1]
+    struct Arrival
+    {
+        PersonId person;
+        uint32_t uneven;
+    };
+    std::vector<std::vector<Arrival>> waves;
+    std::vector<uint32_t> links;
+    std::vector<uint32_t> uneven;
+
+    void start(const FamilySnapshot &family)
+    {
+        marks.reset(family.personCount());
+        result.clear();
+    }
+
+    void add(PersonId person)
+    {
+        if (marks.insert(person))
+            result.push_back(person);
+    }
+
+    void addSiblings(const FamilySnapshot &family, PersonId person)
+    {
+        for (PersonId parent : family.parents(person))
+        {
+            for (PersonId sibling : family.children(parent))
+            {
+                if (sibling != person)
+                    add(sibling);
+            }
+        }
+    }
+
+    // Leaves everyone exactly `steps` child links below `person` in `level`
+    void descend(const FamilySnapshot &family, PersonId person, uint32_t steps)
+    {
+        level.assign(1, person);
+        for (uint32_t step = 1; step <= steps && !level.empty(); step++)
+        {
+            marks.reset(family.personCount());
+            next.clear();
+            for (PersonId p : level)
+            {
+                for (PersonId child : family.children(p))
+                {
+                    if (marks.insert(child))
+                        next.push_back(child);
+                }
+            }
+            level.swap(next);
+        }
+    }
+
+    // A common ancestor `up` links above the first person and `down` links
+    // above the second one
+    void offer(PersonId ancestor, uint32_t up, uint32_t down)
+    {
+        auto key = [](uint32_t u, uint32_t d)
+        { return std::make_tuple(u + d, u > d ? u - d : d - u, u); };
+        if (best.related() && key(up, down) > key(best.up, best.down))
+            return;
+        if (!best.related() || key(up, down) < key(best.up, best.down))
+        {
+            best = Kinship{ancestor, up, down};
+            common.clear();
+        }
+        common.push_back(ancestor);
+    }
+
+    Span<PersonId> finish() const
+    {
+        return {result.data(), result.data() + result.size()};
+    }
+};
+
+// Single-threaded front end: collects people and links, and answers queries
+// against a snapshot that is refrozen only after the records have changed.
+// Records added since the last snapshot are kept apart as FamilyChanges, so a
+// refreeze derives the next snapshot from the last one and costs about as
+// much as the changes. Changes that would make the parent links cyclic are
+// dropped by the refreeze that finds them (see addParent).
+class KnowledgeBase
+{
+public:
+    KnowledgeBase() : frozen(std::make_shared<const FamilySnapshot>()) {}
+
+    // Returns the id of a person, creating it if needed
+    PersonId intern(std::string_view name)
+    {
+        uint64_t hash = NameTable::hashName(name);
+        PersonId id = find(name, hash);
+        if (id != NO_PERSON)
+            return id;
+        FamilyRecords &added = changes().added;
+        id = static_cast<PersonId>(frozen->personCount() + added.names.insert(name, hash));
+        added.genders.push_back(Gender::Unknown);
+        return id;
+    }
+
+    // Returns the id of a known person or NO_PERSON
+    PersonId find(std::string_view name) const
+    {
+        return find(name, NameTable::hashName(name));
+    }
+
+    std::string_view name(PersonId person) const
+    {
+        size_t frozenPeople = frozen->personCount();
+        return person < frozenPeople ? frozen->name(person) : pending.added.names.name(person - frozenPeople);
+    }
+
+    size_t personCount() const
+    {
+        return frozen->personCount() + pending.added.names.size();
+    }
+
+    // Add parent-child relationship. Throws, adding nothing, if parent and
+    // child are the same person. Longer cycles are found by the next
+    // snapshot(), which then drops every record added since the last one.
+    void addParent(const std::string &parent, const std::string &child)
+    {
+        if (parent == child)
+            throw std::runtime_error("a person cannot be their own parent: " + parent);
+        addParent(intern(parent), intern(child));
+    }
+
+    void addParent(PersonId parent, PersonId child)
+    {
+        if (parent == child)
+            throw std::runtime_error("a person cannot be their own parent: " + std::string(name(parent)));
+        FamilyRecords &added = changes().added;
+        added.linkParent.push_back(parent);
+        added.linkChild.push_back(child);
+    }
+
+    // Add gender info
+    void addGender(const std::string &person, const std::string &gender)
+    {
+        addGender(intern(person), parseGender(gender));
+    }
+
+    void addGender(PersonId person, Gender gender)
+    {
+        FamilyChanges &c = changes();
+        size_t frozenPeople = frozen->personCount();
+        if (person < frozenPeople)
+            c.genders.emplace_back(person, gender);
+        else
+            c.added.genders[person - frozenPeople] = gender;
+    }
+
+    // Adds people, genders and links loaded in bulk (see family_loader.h).
+    // Into an empty knowledge base the records are moved as they are;
+    // otherwise their people are matched by name.
+    void addRecords(FamilyRecords records)
+    {
+        if (personCount() == 0 && pending.added.linkParent.empty())
+        {
+            changes().added = std::move(records);
+            return;
+        }
+        std::vector<PersonId> ids(records.names.size());
+        for (PersonId p = 0; p < ids.size(); p++)
+        {
+            ids[p] = intern(records.names.name(p));
+            if (records.genders[p] != Gender::Unknown)
+                addGender(ids[p], records.genders[p]);
+        }
+        FamilyRecords &added = changes().added;
+        added.linkParent.reserve(added.linkParent.size() + records.linkParent.size());
+        added.linkChild.reserve(added.linkChild.size() + records.linkChild.size());
+        for (size_t i = 0; i < records.linkParent.size(); i++)
+        {
+            added.linkParent.push_back(ids[records.linkParent[i]]);
+            added.linkChild.push_back(ids[records.linkChild[i]]);
+        }
+    }
+
+    // Pre-reserves storage for bulk loading
+    void reserve(size_t people, size_t links)
+    {
+        FamilyRecords &added = changes().added;
+        added.names.reserve(people, people * 8);
+        added.genders.reserve(people);
+        added.linkParent.reserve(links);
+        added.linkChild.reserve(links);
+    }
+
+    // Moves all records out, leaving the knowledge base empty
+    FamilyRecords release()
+    {
+        FamilyRecords records;
+        if (frozen->personCount() == 0)
+        {
+            records = std::move(pending.added);
+        }
+        else
+        {
+            records = frozen->records();
+            for (const auto &change : pending.genders)
+                records.genders[change.first] = change.second;
+            records.names.append(pending.added.names);
+            records.genders.insert(records.genders.end(), pending.added.genders.begin(), pending.added.genders.end());
+            records.linkParent.insert(records.linkParent.end(), pending.added.linkParent.begin(),
+                                      pending.added.linkParent.end());
+            records.linkChild.insert(records.linkChild.end(), pending.added.linkChild.begin(),
+                                     pending.added.linkChild.end());
+        }
+        *this = KnowledgeBase();
+        return records;
+    }
+
+    // Freezes the current records. The snapshot can be shared with other
+    // threads; it is rebuilt only after the next change, from the previous
+    // one plus the changes. Throws if the new links make someone their own
+    // ancestor; the records added since the last snapshot are then dropped,
+    // so the previous snapshot stays and later queries answer from it.
+    std::shared_ptr<const FamilySnapshot> snapshot()
+    {
+        if (changed)
+        {
+            auto next = std::make_shared<const FamilySnapshot>(*frozen, FamilyChanges{std::move(pending.added), pending.genders});
+            pending.added = FamilyRecords();
+            try
+            {
+                KinshipIndex updated = index;
+                updated.update(*next, scratch);
+                index = std::move(updated);
+            }
+            catch (...)
+            {
+                revert();
+                throw;
+            }
+            frozen = std::move(next);
+            pending.genders.clear();
+            changed = false;
+        }
+        return frozen;
+    }
+
+    // Drops the records added since the last snapshot()
+    void revert()
+    {
+        pending = FamilyChanges();
+        changed = false;
+    }
+
+    // Kinship index of the current snapshot, updated with it
+    const KinshipIndex &kinship()
+    {
+        snapshot();
+        return index;
+    }
+
+    // --- Queries by id; spans stay valid until the next change, and derived
+    // relations until the next query ---
+
+    Span<PersonId> children(PersonId person)
+    {
+        return snapshot()->children(person);
+    }
+
+    Span<PersonId> parents(PersonId person)
+    {
+        return snapshot()->parents(person);
+    }
+
+    Span<PersonId> grandparents(PersonId person)
+    {
+        return search.grandparents(*snapshot(), person);
+    }
+
+    Span<PersonId> siblings(PersonId person)
+    {
+        return search.siblings(*snapshot(), person);
+    }
+
+    Span<PersonId> unclesAunts(PersonId person)
+    {
+        return search.unclesAunts(*snapshot(), person);
+    }
+
+    Span<PersonId> nephewsNieces(PersonId person)
+    {
+        return search.nephewsNieces(*snapshot(), person);
+    }
+
+    bool isAncestor(PersonId ancestor, PersonId person)
+    {
+        return search.isAncestor(*snapshot(), index, ancestor, person);
+    }
+
+    Span<PersonId> ancestorsAt(PersonId person, uint32_t steps)
+    {
+        return search.ancestorsAt(*snapshot(), index, person, steps);
+    }
+
+    Span<PersonId> descendantsAt(PersonId person, uint32_t steps)
+    {
+        return search.descendantsAt(*snapshot(), person, steps);
+    }
+
+    Kinship relationship(PersonId first, PersonId second)
+    {
+        return search.relationship(*snapshot(), first, second);
+    }
+
+    Span<PersonId> nearestCommonAncestors(PersonId first, PersonId second)
+    {
+        return search.nearestCommonAncestors(*snapshot(), first, second);
+    }
+
+    Span<PersonId> cousins(PersonId person, uint32_t degree, uint32_t removed)
+    {
+        return search.cousins(*snapshot(), person, degree, removed);
+    }
+
+    // --- Queries by name; unknown people have no relatives ---
+
+    // Get children of a person
+    std::vector<std::string> getChildren(const std::string &person)
+    {
+        return byName(person, &KnowledgeBase::children);
+    }
+
+    // Get parents of a person
+    std::vector<std::string> getParents(const std::string &person)
+    {
+        return byName(person, &KnowledgeBase::parents);
+    }
+
+    // Get grandparents of a person
+    std::vector<std::string> getGrandparents(const std::string &person)
+    {
+        return byName(person, &KnowledgeBase::grandparents);
+    }
+
+    // Get siblings of a person
+    std::vector<std::string> getSiblings(const std::string &person)
+    {
+        return byName(person, &KnowledgeBase::siblings);
+    }
+
+    std::vector<std::string> getUnclesAunts(const std::string &person)
+    {
+        return byName(person, &KnowledgeBase::unclesAunts);
+    }
+
+    std::vector<std::string> getNephewsNieces(const std::string &person)
+    {
+        return byName(person, &KnowledgeBase::nephewsNieces);
+    }
+
+    std::vector<std::string> getCousins(const std::string &person, uint32_t degree, uint32_t removed)
+    {
+        PersonId id = find(person);
+        if (id == NO_PERSON)
+            return {};
+        return names(cousins(id, degree, removed));
+    }
+
+    // What `other` is to `person`, e.g. "first cousin once removed"
+    std::string getRelationship(const std::string &person, const std::string &other)
+    {
+        PersonId a = find(person), b = find(other);
+        return a == NO_PERSON || b == NO_PERSON ? describe(Kinship{}) : describe(relationship(a, b));
+    }
+
+    // Get gender of a person
+    std::string getGender(const std::string &person) const
+    {
+        PersonId id = find(person);
+        return genderName(id == NO_PERSON ? Gender::Unknown : gender(id));
+    }
+
+private:
+    std::shared_ptr<const FamilySnapshot> frozen;
+    FamilyChanges pending; // since `frozen`; new people have ids from frozen->personCount() on
+    bool changed = false;
+    KinshipIndex index;
+    KinshipIndex::Scratch scratch;
+    KinshipSearch search;
+
+    FamilyChanges &changes()
+    {
+        changed = true;
+        return pending;
+    }
+
+    PersonId find(std::string_view name, uint64_t hash) const
+    {
+        PersonId id = frozen->find(name, hash);
+        if (id != NO_PERSON)
+            return id;
+        id = pending.added.names.find(name, hash);
+        return id == NO_PERSON ? NO_PERSON : static_cast<PersonId>(frozen->personCount() + id);
+    }
+
+    // Including changes that are not frozen yet
+    Gender gender(PersonId person) const
+    {
+        size_t frozenPeople = frozen->personCount();
+        if (person >= frozenPeople)
+            return pending.added.genders[person - frozenPeople];
+        for (auto change = pending.genders.rbegin(); change != pending.genders.rend(); ++change)
+        {
+            if (change->first == person)
+                return change->second;
+        }
+        return frozen->gender(person);
+    }
+
+    std::vector<std::string> byName(const std::string &person, Span<PersonId> (KnowledgeBase::*relation)(PersonId))
+    {
+        PersonId id = find(person);
+        if (id == NO_PERSON)
+            return {};
+        return names((this->*relation)(id));
+    }
+
+    std::vector<std::string> names(Span<PersonId> people) const
+    {
+        std::vector<std::string> result;
+        for (PersonId p : people)
+            result.emplace_back(name(p));
+        return result;
+    }
+};
+
+// --- Benchmark generators ---
+
+// A synthetic family tree of `people` people in generations of `generation`
+// people. Everyone outside the first generation gets two distinct parents
+// from the generation before, so there are about 2 * people links.
+inline void makeFamilyTree(KnowledgeBase &kb, size_t people, size_t generation, unsigned seed)
+{
+    generation = std::max<size_t>(generation, 2);
+    kb.reserve(people, 2 * people);
+    for (size_t i = 0; i < people; i++)
+        kb.intern("p" + std::to_string(i));
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, generation - 1);
+    for (size_t child = generation; child < people; child++)
+    {
+        size_t first = child / generation * generation - generation;
+        size_t mother = first + pick(rng), father;
+        do
+            father = first + pick(rng);
+        while (father == mother);
+        kb.addParent(static_cast<PersonId>(mother), static_cast<PersonId>(child));
+        kb.addParent(static_cast<PersonId>(father), static_cast<PersonId>(child));
+    }
+}
@@ -1,158 +1,526 @@
 #include <iostream>
 #include <vector>
-#include <queue>
-#include <map>
-#include <algorithm>
-#include <set>
 #include <string>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <random>
+#include "a_star.h"
+#include "graph_io.h"
+#include "graph_image.h"
+#include "landmarks.h"
+#include "contraction_hierarchy.h"
+#include "distance_table.h"
+#include "jump_point_search.h"
+#include "route_problem.h"
+#include "../common/search.h"
 
 using namespace std;
 
-// Node class
-class Node
+// A* Graph class
+// Collects named edges and hand-entered heuristics. The searchable graph is
+// frozen from them on the first query after a change; it is immutable and can
+// be shared with other threads that search it through their own SearchContext.
+class AStarExample
 {
+private:
+    GraphBuilder builder;
+    Graph graph;
+    bool graphDirty = true;
+    vector<double> heuristic; // by node id
+    SearchContext context;
+
 public:
-    // f(n)=g(n)+h(n)
-    string name; // name of node
-    double g;    // cost from start
-    double h;    // heuristic cost
-    double f;    // g + h
-    Node *parent;
-
-    Node(string n) : name(n), g(0), h(0), f(0), parent(nullptr) {}
-};
+    NodeId getNode(const string &name)
+    {
+        NodeId id = builder.node(name);
+        if (heuristic.size() <= id)
+        {
+            heuristic.resize(id + 1, 0);
+            graphDirty = true;
+        }
+        return id;
+    }
 
-// Comparator for priority_queue (min-heap based on f)
-struct CompareNode
-{
-    bool operator()(Node *a, Node *b)
+    void addEdge(const string &from, const string &to, double cost)
+    {
+        builder.addEdge(getNode(from), getNode(to), cost); // undirected
+        graphDirty = true;
+    }
+
+    void setHeuristic(const string &node, double hValue)
+    {
+        heuristic[getNode(node)] = hValue;
+    }
+
+    const Graph &getGraph()
     {
-        return a->f > b->f; // min-heap
+        if (graphDirty)
+        {
+            graph = builder.build();
+            graphDirty = false;
+        }
+        return graph;
+    }
+
+    TableHeuristic getHeuristic() const
+    {
+        return {&heuristic};
+    }
+
+    vector<string> aStarSearch(const string &start, const string &goal)
+    {
+        NodeId startNode = getNode(start);
+        NodeId goalNode = getNode(goal);
+        const Graph &g = getGraph();
+
+        if (!context.aStar(g, startNode, goalNode, getHeuristic()))
+            return {}; // No path found
+        return reconstructPath(g, context.path(goalNode));
+    }
+
+    static vector<string> reconstructPath(const Graph &g, const vector<NodeId> &nodes)
+    {
+        vector<string> path;
+        for (NodeId v : nodes)
+            path.push_back(g.name(v));
+        return path;
     }
 };
 
-// Edge class
-class Edge
+void printPath(const vector<string> &path)
 {
-public:
-    Node *from;
-    Node *to;
-    double cost;
+    cout << "[";
+    for (size_t i = 0; i < path.size(); i++)
+    {
+        cout << path[i];
+        if (i != path.size() - 1)
+            cout << ", ";
+    }
+    cout << "]";
+}
 
-    Edge(Node *f, Node *t, double c) : from(f), to(t), cost(c) {}
-};
+double secondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
 
-// A* Graph class
-class AStarExample
+// Cost of a path along arcs of g, or -1 if two consecutive nodes are not joined
+double pathCost(const Graph &g, const vector<NodeId> &path)
 {
-private:
-    map<string, Node *> nodes;
-    vector<Edge> edges;
-    map<string, double> heuristic;
+    double cost = 0;
+    for (size_t i = 1; i < path.size(); i++)
+    {
+        double cheapest = -1;
+        for (uint32_t a = g.arcsBegin(path[i - 1]); a < g.arcsEnd(path[i - 1]); a++)
+        {
+            if (g.arcHead(a) == path[i] && (cheapest < 0 || g.arcWeight(a) < cheapest))
+                cheapest = g.arcWeight(a);
+        }
+        if (cheapest < 0)
+            return -1;
+        cost += cheapest;
+    }
+    return cost;
+}
 
+// Runs the same random queries with Dijkstra and every available heuristic,
+// and checks that all of them find the same distances.
+class QueryBenchmark
+{
 public:
-    Node *getNode(const string &name)
+    QueryBenchmark(const Graph &g, size_t queries) : g(g), pairs(queries)
     {
-        if (nodes.find(name) == nodes.end())
-            nodes[name] = new Node(name);
-        return nodes[name];
+        mt19937 rng(12345);
+        uniform_int_distribution<NodeId> pick(0, static_cast<NodeId>(g.nodeCount() - 1));
+        for (auto &q : pairs)
+            q = {pick(rng), pick(rng)};
     }
 
-    void addEdge(const string &from, const string &to, double cost)
+    // `makeHeuristic(goal)` returns the heuristic for one query
+    template <class MakeHeuristic>
+    void run(const string &name, MakeHeuristic makeHeuristic)
+    {
+        SearchContext context;
+        measure(name, [&](NodeId start, NodeId goal, size_t &settled)
+                {
+                    bool found = context.aStar(g, start, goal, makeHeuristic(goal));
+                    settled += context.settledCount();
+                    return found ? context.distance(goal) : -1.0; });
+    }
+
+    // The same A* through the generic engine of search.h, which hashes states
+    // instead of indexing labels by node id
+    template <class MakeHeuristic>
+    void runGeneric(const string &name, MakeHeuristic makeHeuristic)
     {
-        Node *n1 = getNode(from);
-        Node *n2 = getNode(to);
-        edges.push_back(Edge(n1, n2, cost));
-        edges.push_back(Edge(n2, n1, cost)); // undirected
+        using Problem = RouteProblem<decltype(makeHeuristic(NodeId()))>;
+        Search<Problem> search;
+        measure(name, [&](NodeId start, NodeId goal, size_t &settled)
+                {
+                    bool found = search.aStar(makeRouteProblem(g, goal, makeHeuristic(goal)), start);
+                    settled += search.expandedCount();
+                    return found ? search.cost() : -1.0; });
     }
 
-    void setHeuristic(const string &node, double hValue)
+    // Bidirectional A* with `makeToGoal(goal)` and `makeFromStart(start)` as the
+    // two lower bounds; also checks that the joined path has the reported length
+    template <class MakeToGoal, class MakeFromStart>
+    void runBidirectional(const string &name, const Graph &reverse, MakeToGoal makeToGoal, MakeFromStart makeFromStart)
     {
-        heuristic[node] = hValue;
+        BidirectionalSearchContext context;
+        measure(name, [&](NodeId start, NodeId goal, size_t &settled)
+                {
+                    bool found = context.aStar(g, reverse, start, goal, makeToGoal(goal), makeFromStart(start));
+                    settled += context.settledCount();
+                    if (!found)
+                        return -1.0;
+                    double cost = pathCost(g, context.path());
+                    return abs(cost - context.distance()) > 1e-6 * max(1.0, cost) ? -2.0 : context.distance(); });
     }
 
-    vector<string> aStarSearch(const string &start, const string &goal)
+    // `query(start, goal, settled)` returns the distance, or -1 if there is no
+    // path, and adds the nodes it settled to `settled`
+    template <class Query>
+    void measure(const string &name, Query query)
     {
-        Node *startNode = getNode(start);
-        Node *goalNode = getNode(goal);
+        size_t settled = 0, mismatches = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < pairs.size(); i++)
+        {
+            double d = query(pairs[i].first, pairs[i].second, settled);
+            if (reference.size() < pairs.size())
+                reference.push_back(d);
+            else
+                mismatches += abs(d - reference[i]) > 1e-6 * max(1.0, d);
+        }
+        cout << name << ": " << secondsSince(start) * 1000 / pairs.size() << " ms/query, "
+             << settled / pairs.size() << " settled nodes/query, " << mismatches << " mismatches\n";
+    }
 
-        priority_queue<Node *, vector<Node *>, CompareNode> openList;
-        set<Node *> closedList;
+private:
+    const Graph &g;
+    vector<pair<NodeId, NodeId>> pairs;
+    vector<double> reference; // distances found by the first run
+};
 
-        startNode->g = 0;
-        startNode->h = heuristic[start];
-        startNode->f = startNode->g + startNode->h;
+// Times a size x size distance table between random nodes against the same
+// cells answered one by one with point-to-point A* (on a sample of the rows)
+template <class MakeHeuristic>
+void compareDistanceTable(const Graph &g, size_t size, const string &name, MakeHeuristic makeHeuristic)
+{
+    mt19937 rng(54321);
+    uniform_int_distribution<NodeId> pick(0, static_cast<NodeId>(g.nodeCount() - 1));
+    vector<NodeId> sources(size), targets(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        sources[i] = pick(rng);
+        targets[i] = pick(rng);
+    }
 
-        openList.push(startNode);
+    ManyToManySearch manyToMany;
+    auto start = chrono::steady_clock::now();
+    DistanceTable table = manyToMany.compute(g, sources, targets);
+    double tableSeconds = secondsSince(start);
+    cout << "Distance table " << size << "x" << size << " on " << manyToMany.threads() << " threads: "
+         << tableSeconds << " s, " << size * size / tableSeconds << " cells/s\n";
 
-        while (!openList.empty())
+    size_t sampleRows = min(size, max<size_t>(1, 2000 / size)), mismatches = 0;
+    SearchContext context;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < sampleRows; i++)
+    {
+        for (size_t j = 0; j < size; j++)
         {
-            Node *current = openList.top();
-            openList.pop();
+            double d = HUGE_VAL;
+            if (context.aStar(g, sources[i], targets[j], makeHeuristic(targets[j])))
+                d = context.distance(targets[j]);
+            mismatches += d == HUGE_VAL ? table.at(i, j) != HUGE_VAL : abs(d - table.at(i, j)) > 1e-6 * max(1.0, d);
+        }
+    }
+    double pointSeconds = secondsSince(start);
+    double cellsPerSecond = sampleRows * size / pointSeconds;
+    cout << "Point-to-point " << name << " (" << sampleRows << " rows): " << cellsPerSecond << " cells/s, "
+         << mismatches << " mismatches; table is " << size * size / tableSeconds / cellsPerSecond << "x faster\n";
+}
 
-            if (current->name == goal)
+// Usage: a_star --dimacs <graph.gr> [coordinates.co] [options]
+//        a_star --csv <edges.csv> [options]
+//        a_star --image <graph.img> [options]
+// Options: --queries <n>           random queries to compare (default 100)
+//          --landmarks <k>         build ALT tables with k landmarks
+//          --save-landmarks <file> write the ALT tables to a file
+//          --load-landmarks <file> read ALT tables instead of building them
+//          --bidirectional         also run every heuristic as bidirectional A*
+//          --ch                    build a contraction hierarchy and compare it too
+//          --table <n>             time an n x n many-to-many distance table
+//          --save-image <file>     write the graph as a binary image for --image
+int runLoadedGraph(int argc, char *argv[])
+{
+    bool dimacs = strcmp(argv[1], "--dimacs") == 0, image = strcmp(argv[1], "--image") == 0;
+    // Coordinates only come from DIMACS files, so images use the same metric
+    Metric metric = dimacs || image ? Metric::Haversine : Metric::Euclidean;
+    int next = 3;
+    string coordinates, saveLandmarks, loadLandmarks, saveImage;
+    size_t queries = 100, landmarkCount = 0, tableSize = 0;
+    if (dimacs && argc > next && argv[next][0] != '-')
+        coordinates = argv[next++];
+    bool bidirectional = false, hierarchy = false;
+    for (; next < argc; next++)
+    {
+        string option = argv[next];
+        bool takesValue = option == "--queries" || option == "--table" || option == "--landmarks" ||
+                          option == "--save-landmarks" || option == "--load-landmarks" || option == "--save-image";
+        if (takesValue && next + 1 == argc)
+        {
+            cout << "Missing value for " << option << "\n";
+            return 1;
+        }
+        if (option == "--bidirectional")
+            bidirectional = true;
+        else if (option == "--ch")
+            hierarchy = true;
+        else if (option == "--queries")
+            queries = strtoull(argv[++next], nullptr, 10);
+        else if (option == "--table")
+            tableSize = strtoull(argv[++next], nullptr, 10);
+        else if (option == "--landmarks")
+            landmarkCount = strtoull(argv[++next], nullptr, 10);
+        else if (option == "--save-landmarks")
+            saveLandmarks = argv[++next];
+        else if (option == "--load-landmarks")
+            loadLandmarks = argv[++next];
+        else if (option == "--save-image")
+            saveImage = argv[++next];
+        else
+            break;
+    }
+    if (next < argc)
+    {
+        cout << "Unknown option: " << argv[next] << "\n";
+        return 1;
+    }
+
+    try
+    {
+        auto start = chrono::steady_clock::now();
+        Graph g = dimacs ? loadDimacs(argv[2], coordinates) : image ? GraphImage::map(argv[2]) : loadCsvEdges(argv[2]);
+        cout << (image ? "Mapped " : "Loaded ") << g.nodeCount() << " nodes and " << g.arcCount() << " arcs in "
+             << secondsSince(start) << " s\n";
+        if (!saveImage.empty())
+        {
+            start = chrono::steady_clock::now();
+            GraphImage::write(g, saveImage);
+            cout << "Image written to " << saveImage << " in " << secondsSince(start) << " s\n";
+        }
+
+        Landmarks alt;
+        start = chrono::steady_clock::now();
+        if (!loadLandmarks.empty())
+            alt = Landmarks::load(loadLandmarks, g.nodeCount());
+        else if (landmarkCount > 0)
+            alt = Landmarks::build(g, landmarkCount);
+        if (alt.count() > 0)
+            cout << "Landmarks: " << alt.count() << " ready in " << secondsSince(start) << " s\n";
+        if (!saveLandmarks.empty())
+            alt.save(saveLandmarks);
+
+        if (g.nodeCount() == 0)
+            return 0;
+        if (tableSize > 0)
+        {
+            if (g.hasCoordinates())
+            {
+                CoordinateHeuristic model(g, metric);
+                compareDistanceTable(g, tableSize, "A* (coordinates)", [&](NodeId goal)
+                                     { return model.towards(goal); });
+            }
+            else
             {
-                return reconstructPath(current);
+                compareDistanceTable(g, tableSize, "Dijkstra", [](NodeId)
+                                     { return ZeroHeuristic{}; });
             }
+        }
+        if (queries == 0)
+            return 0;
+        QueryBenchmark benchmark(g, queries);
+        Graph reverse = bidirectional ? g.reversed() : Graph();
+        auto compare = [&](const string &name, auto makeToGoal, auto makeFromStart)
+        {
+            benchmark.run(name, makeToGoal);
+            benchmark.runGeneric("Generic " + name, makeToGoal);
+            if (bidirectional)
+                benchmark.runBidirectional("Bidirectional " + name, reverse, makeToGoal, makeFromStart);
+        };
+        auto none = [](NodeId)
+        { return ZeroHeuristic{}; };
+        compare("Dijkstra", none, none);
+        if (g.hasCoordinates())
+        {
+            CoordinateHeuristic model(g, metric);
+            compare("A* (coordinates)", [&](NodeId goal)
+                    { return model.towards(goal); }, [&](NodeId start)
+                    { return model.from(start); });
+        }
+        if (alt.count() > 0)
+        {
+            compare("A* (ALT, " + to_string(alt.count()) + " landmarks)", [&](NodeId goal)
+                    { return alt.towards(goal); }, [&](NodeId start)
+                    { return alt.from(start); });
+        }
+        if (hierarchy)
+        {
+            start = chrono::steady_clock::now();
+            ContractionHierarchy ch = ContractionHierarchy::build(g);
+            cout << "Contraction hierarchy: " << ch.shortcutCount() << " shortcuts in " << secondsSince(start) << " s\n";
+            HierarchySearchContext context;
+            benchmark.measure("Contraction hierarchy", [&](NodeId from, NodeId to, size_t &settled)
+                              {
+                                  bool found = context.query(ch, from, to);
+                                  settled += context.settledCount();
+                                  if (!found)
+                                      return -1.0;
+                                  // The unpacked path must be a real path of the same length
+                                  double cost = pathCost(g, context.path());
+                                  return abs(cost - context.distance()) > 1e-6 * max(1.0, cost) ? -2.0 : context.distance(); });
+        }
+    }
+    catch (const exception &e)
+    {
+        cout << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
 
-            closedList.insert(current);
+// Usage: a_star --map <file.map> [--scen <file.scen>] [--queries <n>]
+// Compares A* on the map as an explicit graph, A* on the implicit grid and
+// Jump Point Search with cellwise and bit-parallel scans. Queries come from
+// the scenario file (whose optimal lengths are checked too) or are random.
+int runGridMap(int argc, char *argv[])
+{
+    string scenarioPath;
+    size_t queries = 100;
+    for (int next = 3; next < argc; next += 2)
+    {
+        string option = argv[next];
+        if (option == "--scen" && next + 1 < argc)
+            scenarioPath = argv[next + 1];
+        else if (option == "--queries" && next + 1 < argc)
+            queries = strtoull(argv[next + 1], nullptr, 10);
+        else
+        {
+            cout << "Unknown option: " << option << "\n";
+            return 1;
+        }
+    }
 
-            for (Edge &edge : edges)
+    try
+    {
+        auto start = chrono::steady_clock::now();
+        GridMap map = GridMap::loadMovingAI(argv[2]);
+        cout << "Loaded " << map.width() << "x" << map.height() << " map in " << secondsSince(start) << " s\n";
+
+        vector<pair<NodeId, NodeId>> pairs;
+        vector<double> optimal;
+        if (!scenarioPath.empty())
+        {
+            vector<GridScenario> scenarios = loadScenarios(scenarioPath);
+            for (size_t i = 0; i < scenarios.size(); i++)
             {
-                // FOR ALL EDGES WHERE CURRENT -> NEIGHBOR
-                if (edge.from == current)
-                {
-                    Node *neighbor = edge.to;
-
-                    if (closedList.count(neighbor))
-                        continue;
-
-                    double tentativeG = current->g + edge.cost;
-
-                    // Check if neighbor is already in openList with higher g
-                    bool inOpen = false;
-                    priority_queue<Node *, vector<Node *>, CompareNode> temp = openList;
-                    while (!temp.empty())
-                    {
-                        if (temp.top() == neighbor)
-                        {
-                            inOpen = true;
-                            break;
-                        }
-                        temp.pop();
-                    }
-
-                    if (!inOpen || tentativeG < neighbor->g) // if the neighbour is not already in the open list we will add it up
-                    {
-                        neighbor->parent = current;
-                        neighbor->g = tentativeG;
-                        neighbor->h = heuristic[neighbor->name];
-                        neighbor->f = neighbor->g + neighbor->h;
-
-                        if (!inOpen)
-                        {
-                            openList.push(neighbor);
-                        }
-                    }
-                }
+                // A scenario file made for another map can name cells this one does not have
+                const GridScenario &s = scenarios[i];
+                auto inside = [&](int x, int y)
+                { return x >= 0 && x < map.width() && y >= 0 && y < map.height(); };
+                if (!inside(s.startX, s.startY) || !inside(s.goalX, s.goalY))
+                    throw runtime_error(scenarioPath + ": query " + to_string(i + 1) + " goes from (" +
+                                        to_string(s.startX) + ", " + to_string(s.startY) + ") to (" + to_string(s.goalX) +
+                                        ", " + to_string(s.goalY) + "), outside the " + to_string(map.width()) + "x" +
+                                        to_string(map.height()) + " map");
+                pairs.push_back({map.cell(s.startX, s.startY), map.cell(s.goalX, s.goalY)});
+                optimal.push_back(s.optimalLength);
             }
         }
-        // When all possible nodes have been explored and goal is not found, we return:
-        return {}; // No path found
+        else
+        {
+            vector<NodeId> open;
+            for (NodeId c = 0; c < map.cellCount(); c++)
+            {
+                if (map.passable(map.x(c), map.y(c)))
+                    open.push_back(c);
+            }
+            if (open.empty())
+                return 0;
+            mt19937 rng(12345);
+            uniform_int_distribution<size_t> pick(0, open.size() - 1);
+            for (size_t i = 0; i < queries; i++)
+                pairs.push_back({open[pick(rng)], open[pick(rng)]});
+        }
+
+        start = chrono::steady_clock::now();
+        Graph g = map.toGraph();
+        cout << "Explicit graph: " << g.arcCount() << " arcs built in " << secondsSince(start) << " s\n";
+
+        // Every method must agree with the first one, and with the scenario if there is one
+        vector<double> reference;
+        auto measure = [&](const string &name, auto query)
+        {
+            size_t settled = 0, mismatches = 0;
+            auto begin = chrono::steady_clock::now();
+            for (size_t i = 0; i < pairs.size(); i++)
+            {
+                double d = query(pairs[i].first, pairs[i].second, settled);
+                if (reference.size() < pairs.size())
+                    reference.push_back(d);
+                else
+                    mismatches += abs(d - reference[i]) > 1e-6 * max(1.0, d);
+                if (i < optimal.size())
+                    mismatches += abs(d - optimal[i]) > 1e-4 * max(1.0, d);
+            }
+            cout << name << ": " << secondsSince(begin) * 1000 / pairs.size() << " ms/query, "
+                 << settled / pairs.size() << " expanded/query, " << mismatches << " mismatches\n";
+        };
+
+        SearchContext context;
+        measure("A* (explicit graph)", [&](NodeId from, NodeId to, size_t &settled)
+                {
+                    bool found = context.aStar(g, from, to, map.towards(to));
+                    settled += context.settledCount();
+                    return found ? context.distance(to) : -1.0; });
+        GridSearch grid;
+        measure("A* (implicit grid)", [&](NodeId from, NodeId to, size_t &settled)
+                {
+                    bool found = grid.aStar(map, from, to);
+                    settled += grid.settledCount();
+                    return found ? grid.distance(to) : -1.0; });
+        measure("JPS (cellwise scans)", [&](NodeId from, NodeId to, size_t &settled)
+                {
+                    bool found = grid.jumpPointSearch(map, from, to, GridSearch::Scan::Cellwise);
+                    settled += grid.settledCount();
+                    return found ? grid.distance(to) : -1.0; });
+        measure("JPS (bit-parallel scans)", [&](NodeId from, NodeId to, size_t &settled)
+                {
+                    bool found = grid.jumpPointSearch(map, from, to, GridSearch::Scan::BitParallel);
+                    settled += grid.settledCount();
+                    return found ? grid.distance(to) : -1.0; });
     }
-    // when goal is found this function runs
-    vector<string> reconstructPath(Node *goal)
+    catch (const exception &e)
     {
-        vector<string> path;
-        for (Node *n = goal; n != nullptr; n = n->parent)
-            path.push_back(n->name);
-        reverse(path.begin(), path.end());
-        return path;
+        cout << "Error: " << e.what() << "\n";
+        return 1;
     }
-};
+    return 0;
+}
 
-int main()
+int main(int argc, char *argv[])
 {
+    if (argc >= 3 && (strcmp(argv[1], "--dimacs") == 0 || strcmp(argv[1], "--csv") == 0 ||
+                      strcmp(argv[1], "--image") == 0))
+        return runLoadedGraph(argc, argv);
+    if (argc >= 3 && strcmp(argv[1], "--map") == 0)
+        return runGridMap(argc, argv);
+
     AStarExample graph;
 
     // Graph edges
@@ -174,19 +542,38 @@ int main()
 
     if (!path.empty())
     {
-        cout << "Shortest Path: [";
-        for (size_t i = 0; i < path.size(); i++)
-        {
-            cout << path[i];
-            if (i != path.size() - 1)
-                cout << ", ";
-        }
-        cout << "]\n";
+        cout << "Shortest Path: ";
+        printPath(path);
+        cout << "\n";
     }
     else
     {
         cout << "No path found!\n";
     }
 
+    // The frozen graph can be searched from several threads at once,
+    // each with its own search context and no locking
+    const Graph &shared = graph.getGraph();
+    TableHeuristic h = graph.getHeuristic();
+    vector<vector<string>> results(4);
+    vector<thread> workers;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        workers.emplace_back([&, i]
+                             {
+                                 SearchContext context;
+                                 NodeId start = shared.find("A"), goal = shared.find("E");
+                                 if (context.aStar(shared, start, goal, h))
+                                     results[i] = AStarExample::reconstructPath(shared, context.path(goal)); });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        cout << "Thread " << i << " path: ";
+        printPath(results[i]);
+        cout << "\n";
+    }
+
     return 0;
 }
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "../common/indexed_heap.h"
+#include "../common/instrumentation.h"
+#include "graph.h"
+
+// --- Heuristics ---
+// A heuristic is any callable double(NodeId) that estimates the remaining
+// cost from a node to the goal of the current query.
+
+// h = 0 turns A* into Dijkstra's algorithm
+struct ZeroHeuristic
+{
+    double operator()(NodeId) const
+    {
+        return 0;
+    }
+};
+
+// Hand-entered estimates, one per node id
+struct TableHeuristic
+{
+    const std::vector<double> *values;
+
+    double operator()(NodeId v) const
+    {
+        return v < values->size() ? (*values)[v] : 0;
+    }
+};
+
+enum class Metric
+{
+    Euclidean, // planar x/y
+    Haversine  // great-circle meters between longitude/latitude in degrees
+};
+
+// Lower bounds computed on the fly from node coordinates.
+// The straight-line distance to the goal is multiplied by a cost per distance
+// unit, e.g. 1 / (top speed) for travel times. Unless one is given, the
+// factor is calibrated as the smallest cost / distance ratio over all arcs,
+// which keeps the estimate admissible and consistent for any weights.
+class CoordinateHeuristic
+{
+public:
+    CoordinateHeuristic(const Graph &graph, Metric metric, double costPerUnit = 0)
+        : graph(&graph), metric(metric), scale(costPerUnit)
+    {
+        if (scale > 0)
+            return;
+        scale = HUGE_VAL;
+        for (NodeId v = 0; v < graph.nodeCount(); v++)
+        {
+            for (uint32_t a = graph.arcsBegin(v); a < graph.arcsEnd(v); a++)
+            {
+                double length = distance(v, graph.arcHead(a));
+                if (length > 0)
+                    scale = std::min(scale, graph.arcWeight(a) / length);
+            }
+        }
+        // Shrink a little so that rounding in distance() cannot break consistency
+        scale = scale == HUGE_VAL ? 0 : scale * (1 - 1e-9);
+    }
+
+    double costPerUnit() const
+    {
+        return scale;
+    }
+
+    double distance(NodeId a, NodeId b) const
+    {
+        const Point &p = graph->coordinate(a);
+        const Point &q = graph->coordinate(b);
+        if (metric == Metric::Euclidean)
+            return std::hypot(p.x - q.x, p.y - q.y);
+
+        const double toRadians = 3.14159265358979323846 / 180;
+        double dLat = (q.y - p.y) * toRadians;
+        double dLon = (q.x - p.x) * toRadians;
+        double s = std::sin(dLat / 2) * std::sin(dLat / 2) +
+                   std::cos(p.y * toRadians) * std::cos(q.y * toRadians) * std::sin(dLon / 2) * std::sin(dLon / 2);
+        return 2 * 6371000.0 * std::asin(std::min(1.0, std::sqrt(s)));
+    }
+
+    // Estimate of the remaining cost from a node to `goal`
+    struct Towards
+    {
+        const CoordinateHeuristic *model;
+        NodeId goal;
+
+        double operator()(NodeId v) const
+        {
+            return model->scale * model->distance(v, goal);
+        }
+    };
+
+    Towards towards(NodeId goal) const
+    {
+        return {this, goal};
+    }
+
+    // Estimate of the cost from `source` to a node; the straight-line
+    // distance is symmetric, so this is the same bound seen from the other end
+    Towards from(NodeId source) const
+    {
+        return {this, source};
+    }
+
+private:
+    const Graph *graph;
+    Metric metric;
+    double scale;
+};
+
+// Per-query state of a shortest-path search.
+//
+// Distances, parents and the open/closed state live in one flat array indexed
+// by node id instead of on the graph, so the graph itself stays immutable and
+// any number of threads can search it at once, each with its own context.
+// The array and the heap are allocated once and reused by every query on the
+// context: each label carries the generation of the query that wrote it, and
+// labels from older generations count as unreached, so starting a new query
+// costs O(1) and a query only touches the nodes it reaches.
+class SearchContext
+{
+public:
+    // A* from `start` until `goal` is settled; returns false if it is unreachable.
+    // With goal == NO_NODE it settles everything reachable (one-to-all Dijkstra
+    // when h = 0). The path found is optimal for any admissible heuristic;
+    // with a consistent one no node is ever settled twice.
+    template <class Heuristic>
+    bool aStar(const Graph &graph, NodeId start, NodeId goal, const Heuristic &h)
+    {
+        AI_PHASE("astar.query");
+        begin(graph.nodeCount());
+        label(start, 0, NO_NODE);
+        open.push(start, h(start));
+
+        bool found = false;
+        size_t scanned = 0, pruned = 0;
+        while (!open.empty())
+        {
+            NodeId current = open.pop();
+            settle(current);
+
+            if (current == goal)
+            {
+                found = true;
+                break;
+            }
+
+            double g = labels[current].distance;
+            scanned += graph.arcsEnd(current) - graph.arcsBegin(current);
+            for (uint32_t a = graph.arcsBegin(current); a < graph.arcsEnd(current); a++)
+            {
+                NodeId neighbor = graph.arcHead(a);
+                double tentativeG = g + graph.arcWeight(a);
+                if (!reached(neighbor))
+                {
+                    label(neighbor, tentativeG, current);
+                    open.push(neighbor, tentativeG + h(neighbor));
+                }
+                else if (tentativeG < labels[neighbor].distance)
+                {
+                    if (open.contains(neighbor))
+                    {
+                        // The key is g + h, and h does not change, so shift it by the improvement
+                        double key = open.key(neighbor) - (labels[neighbor].distance - tentativeG);
+                        label(neighbor, tentativeG, current);
+                        open.decreaseKey(neighbor, key);
+                    }
+                    else
+                    {
+                        // Only possible when h is not consistent: reopen the settled node
+                        label(neighbor, tentativeG, current);
+                        open.push(neighbor, tentativeG + h(neighbor));
+                    }
+                }
+                else
+                {
+                    pruned++;
+                }
+            }
+        }
+        AI_COUNT_ADD(NodesExpanded, settledNodes);
+        AI_COUNT_ADD(NodesGenerated, scanned);
+        AI_COUNT_ADD(DuplicatesPruned, pruned);
+        (void)scanned;
+        (void)pruned;
+        return found;
+    }
+
+    // --- Results of the last query ---
+
+    bool reached(NodeId v) const
+    {
+        return v < labels.size() && (labels[v].stamp == generation || labels[v].stamp == generation + 1);
+    }
+
+    bool settled(NodeId v) const
+    {
+        return v < labels.size() && labels[v].stamp == generation + 1;
+    }
+
+    double distance(NodeId v) const
+    {
+        return labels[v].distance;
+    }
+
+    NodeId parent(NodeId v) const
+    {
+        return labels[v].parent;
+    }
+
+    // Nodes from the start to `goal` following the parent links
+    std::vector<NodeId> path(NodeId goal) const
+    {
+        std::vector<NodeId> nodes;
+        if (!reached(goal))
+            return nodes;
+        for (NodeId v = goal; v != NO_NODE; v = labels[v].parent)
+            nodes.push_back(v);
+        std::reverse(nodes.begin(), nodes.end());
+        return nodes;
+    }
+
+    size_t settledCount() const
+    {
+        return settledNodes;
+    }
+
+    // --- Building blocks for other searches over the same labels ---
+
+    // Starts a new query on a graph with `nodeCount` nodes
+    void begin(size_t nodeCount)
+    {
+        if (labels.size() < nodeCount)
+            labels.resize(nodeCount, Label{0, NO_NODE, 0});
+        open.reserveIds(nodeCount);
+        open.clear();
+        settledNodes = 0;
+        generation += 2;
+        if (generation >= UINT32_MAX - 2)
+        {
+            // Stamps are about to wrap around: forget every old label once
+            for (Label &l : labels)
+                l.stamp = 0;
+            generation = 2;
+        }
+    }
+
+    void label(NodeId v, double dist, NodeId from)
+    {
+        labels[v] = {dist, from, generation};
+    }
+
+    void settle(NodeId v)
+    {
+        labels[v].stamp = generation + 1;
+        settledNodes++;
+    }
+
+    IndexedDaryHeap<double> &queue()
+    {
+        return open;
+    }
+
+private:
+    struct Label
+    {
+        double distance;
+        NodeId parent;
+        uint32_t stamp; // generation: reached in this query; generation + 1: settled
+    };
+
+    std::vector<Label> labels;
+    IndexedDaryHeap<double> open;
+    uint32_t generation = 2; // labels start at stamp 0, which no query uses
+    size_t settledNodes = 0;
+};
+
+// Bidirectional A*: a forward search from the start and a backward search
+// from the goal (on the reversed graph) that meet in the middle.
+//
+// Each search needs a potential, and the two must agree or the meeting point
+// proves nothing. With a lower bound pi_t(v) on d(v, goal) and a lower bound
+// pi_s(v) on d(start, v), both consistent, the averaged potentials
+//     p_f(v) = (pi_t(v) - pi_s(v)) / 2    and    p_r(v) = -p_f(v)
+// are both consistent for their direction. They turn the problem into plain
+// bidirectional Dijkstra on arcs reweighted to w(u, v) - p_f(u) + p_f(v) >= 0,
+// so the usual stopping rule applies: with keys d_f + p_f and d_r + p_r, no
+// path shorter than the best one found (mu) remains once the two smallest
+// keys add up to mu.
+class BidirectionalSearchContext
+{
+public:
+    // `reverse` must be graph.reversed(). `toGoal(v)` bounds d(v, goal) and
+    // `fromStart(v)` bounds d(start, v). Returns false if there is no path.
+    template <class ToGoal, class FromStart>
+    bool aStar(const Graph &graph, const Graph &reverse, NodeId start, NodeId goal,
+               const ToGoal &toGoal, const FromStart &fromStart)
+    {
+        AI_PHASE("astar.bidirectional_query");
+        auto potential = [&](NodeId v)
+        { return (toGoal(v) - fromStart(v)) / 2; };
+
+        forward.begin(graph.nodeCount());
+        backward.begin(graph.nodeCount());
+        best = HUGE_VAL;
+        meeting = NO_NODE;
+        forward.label(start, 0, NO_NODE);
+        forward.queue().push(start, potential(start));
+        backward.label(goal, 0, NO_NODE);
+        backward.queue().push(goal, -potential(goal));
+        if (start == goal)
+        {
+            best = 0;
+            meeting = start;
+        }
+
+        while (!forward.queue().empty() && !backward.queue().empty() &&
+               forward.queue().topKey() + backward.queue().topKey() < best)
+        {
+            if (forward.queue().topKey() <= backward.queue().topKey())
+                step(forward, backward, graph, potential, 1);
+            else
+                step(backward, forward, reverse, potential, -1);
+        }
+        AI_COUNT_ADD(NodesExpanded, settledCount());
+        return meeting != NO_NODE;
+    }
+
+    double distance() const
+    {
+        return best;
+    }
+
+    size_t settledCount() const
+    {
+        return forward.settledCount() + backward.settledCount();
+    }
+
+    // The forward parent chain up to the meeting node, then the backward one
+    std::vector<NodeId> path() const
+    {
+        std::vector<NodeId> nodes = forward.path(meeting);
+        if (meeting == NO_NODE)
+            return nodes;
+        for (NodeId v = backward.parent(meeting); v != NO_NODE; v = backward.parent(v))
+            nodes.push_back(v);
+        return nodes;
+    }
+
+private:
+    SearchContext forward;
+    SearchContext backward;
+    double best = HUGE_VAL;
+    NodeId meeting = NO_NODE;
+
+    // Settles the top node of `side`; `sign` turns p_f into this side's potential
+    template <class Potential>
+    void step(SearchContext &side, const SearchContext &other, const Graph &graph, const Potential &potential, double sign)
+    {
+        NodeId v = side.queue().pop();
+        side.settle(v);
+        double g = side.distance(v);
+        AI_COUNT_ADD(NodesGenerated, graph.arcsEnd(v) - graph.arcsBegin(v));
+        for (uint32_t a = graph.arcsBegin(v); a < graph.arcsEnd(v); a++)
+        {
+            NodeId w = graph.arcHead(a);
+            double tentative = g + graph.arcWeight(a);
+            if (side.reached(w) && tentative >= side.distance(w))
+                continue;
+            // Also reopens a settled node, which only happens when float
+            // rounding makes the potentials very slightly inconsistent
+            side.label(w, tentative, v);
+            side.queue().pushOrDecrease(w, tentative + sign * potential(w));
+            if (other.reached(w) && tentative + other.distance(w) < best)
+            {
+                best = tentative + other.distance(w);
+                meeting = w;
+            }
+        }
+    }
+};
@@ -0,0 +1,479 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "../common/indexed_heap.h"
+#include "a_star.h"
+#include "graph.h"
+
+// Contraction Hierarchies (Geisberger et al.).
+//
+// Preprocessing removes ("contracts") the nodes one at a time, least important
+// first. When node v goes, every path u -> v -> w through it that is the only
+// shortest way from u to w is replaced by a shortcut arc u -> w. Afterwards each
+// node has a rank (its position in the order) and every shortest path can be
+// written as arcs going up in rank followed by arcs going down. A query is then
+// two small Dijkstra searches that only climb: forward from the source over
+// upward arcs, backward from the target over downward arcs, meeting at the
+// highest node of the path.
+//
+// Both search graphs are kept in CSR form. Every arc remembers the edge it
+// stands for, and a shortcut edge remembers the two edges it replaced, so a
+// path can be unpacked back into arcs of the original graph.
+class ContractionHierarchy
+{
+public:
+    static constexpr uint32_t ORIGINAL = std::numeric_limits<uint32_t>::max();
+
+    // An original arc (first == ORIGINAL) or a shortcut for edges first, second
+    struct Edge
+    {
+        NodeId from;
+        NodeId to;
+        uint32_t first;
+        uint32_t second;
+    };
+
+    ContractionHierarchy() = default;
+
+    // `witnessLimit` caps the nodes settled by each witness search. Giving up
+    // early only adds shortcuts that were not needed; the queries stay exact.
+    static ContractionHierarchy build(const Graph &graph, size_t witnessLimit = 500)
+    {
+        ContractionHierarchy ch;
+        Contraction(graph, witnessLimit).run(ch);
+        return ch;
+    }
+
+    size_t nodeCount() const
+    {
+        return rankOf.size();
+    }
+
+    size_t shortcutCount() const
+    {
+        return shortcuts;
+    }
+
+    // Position of a node in the contraction order
+    uint32_t rank(NodeId v) const
+    {
+        return rankOf[v];
+    }
+
+    // Arcs from each node to higher-ranked nodes, for the forward search
+    const Graph &upward() const
+    {
+        return up;
+    }
+
+    // Arcs into each node from higher-ranked nodes, stored reversed (the head
+    // is the tail of the original arc), for the backward search
+    const Graph &downward() const
+    {
+        return down;
+    }
+
+    uint32_t upwardEdge(uint32_t arc) const
+    {
+        return upEdge[arc];
+    }
+
+    uint32_t downwardEdge(uint32_t arc) const
+    {
+        return downEdge[arc];
+    }
+
+    // Appends the original nodes of `edge` to `path`, except its first node
+    void unpack(uint32_t edge, std::vector<NodeId> &path) const
+    {
+        std::vector<uint32_t> pending{edge};
+        while (!pending.empty())
+        {
+            const Edge &e = edges[pending.back()];
+            pending.pop_back();
+            if (e.first == ORIGINAL)
+            {
+                path.push_back(e.to);
+            }
+            else
+            {
+                pending.push_back(e.second);
+                pending.push_back(e.first);
+            }
+        }
+    }
+
+private:
+    Graph up;
+    Graph down;
+    std::vector<uint32_t> upEdge;   // edge of every upward arc
+    std::vector<uint32_t> downEdge; // edge of every downward arc
+    std::vector<Edge> edges;
+    std::vector<uint32_t> rankOf;
+    size_t shortcuts = 0;
+
+    // State of the preprocessing: an adjacency list graph that loses nodes
+    // and gains shortcuts as the contraction goes on
+    class Contraction
+    {
+    public:
+        Contraction(const Graph &graph, size_t witnessLimit)
+            : n(graph.nodeCount()), out(n), in(n), level(n, 0), changed(n, 0), target(n, 0), witnessLimit(witnessLimit)
+        {
+            for (NodeId v = 0; v < n; v++)
+            {
+                for (uint32_t a = graph.arcsBegin(v); a < graph.arcsEnd(v); a++)
+                {
+                    if (graph.arcHead(a) != v)
+                        addArc(v, graph.arcHead(a), graph.arcWeight(a), ORIGINAL, ORIGINAL, 1);
+                }
+            }
+        }
+
+        void run(ContractionHierarchy &ch)
+        {
+            ch.rankOf.assign(n, 0);
+            ch.shortcuts = 0;
+
+            // Least important first. Contracting a node changes the priorities of
+            // its neighbors; rather than recomputing them all right away, they are
+            // marked, checked again when they reach the top and put back if they
+            // got worse.
+            IndexedDaryHeap<double> queue(n);
+            for (NodeId v = 0; v < n; v++)
+                queue.push(v, priority(v));
+            uint32_t nextRank = 0;
+            while (!queue.empty())
+            {
+                NodeId v = queue.pop();
+                if (changed[v])
+                {
+                    changed[v] = 0;
+                    double current = priority(v);
+                    if (!queue.empty() && current > queue.topKey())
+                    {
+                        queue.push(v, current);
+                        continue;
+                    }
+                }
+                ch.rankOf[v] = nextRank++;
+                ch.shortcuts += contract(v);
+            }
+
+            // The arcs a node had when it was contracted all lead to nodes
+            // contracted later, i.e. higher up
+            GraphBuilder upBuilder, downBuilder;
+            upBuilder.reserveNodes(n);
+            downBuilder.reserveNodes(n);
+            for (NodeId v = 0; v < n; v++)
+            {
+                for (const Arc &arc : out[v])
+                {
+                    upBuilder.addArc(v, arc.other, arc.weight);
+                    ch.upEdge.push_back(arc.edge);
+                }
+                for (const Arc &arc : in[v])
+                {
+                    downBuilder.addArc(v, arc.other, arc.weight);
+                    ch.downEdge.push_back(arc.edge);
+                }
+            }
+            ch.up = std::move(upBuilder).build();
+            ch.down = std::move(downBuilder).build();
+            ch.edges = std::move(edges);
+        }
+
+    private:
+        // Witness searches that only estimate a priority can give up sooner
+        static constexpr size_t ESTIMATE_LIMIT = 50;
+
+        struct Arc
+        {
+            NodeId other;
+            double weight;
+            uint32_t edge;
+            uint32_t hops; // original arcs it stands for
+        };
+
+        // What contracting a node would add
+        struct Estimate
+        {
+            size_t arcs = 0;
+            size_t hops = 0;
+        };
+
+        size_t n;
+        std::vector<std::vector<Arc>> out;
+        std::vector<std::vector<Arc>> in;
+        std::vector<Edge> edges;
+        std::vector<uint32_t> level;
+        std::vector<char> changed; // a neighbor was contracted since the last priority
+        std::vector<char> target;  // the nodes a witness search looks for
+        size_t witnessLimit;
+        SearchContext witness;
+
+        // Adds the arc u -> w, or lowers the weight of an existing one
+        void addArc(NodeId u, NodeId w, double weight, uint32_t first, uint32_t second, uint32_t hops)
+        {
+            auto existing = std::find_if(out[u].begin(), out[u].end(), [&](const Arc &a)
+                                         { return a.other == w; });
+            if (existing != out[u].end() && existing->weight <= weight)
+                return;
+            uint32_t edge = static_cast<uint32_t>(edges.size());
+            edges.push_back({u, w, first, second});
+            if (existing != out[u].end())
+            {
+                *existing = {w, weight, edge, hops};
+                for (Arc &a : in[w])
+                {
+                    if (a.other == u)
+                        a = {u, weight, edge, hops};
+                }
+            }
+            else
+            {
+                out[u].push_back({w, weight, edge, hops});
+                in[w].push_back({u, weight, edge, hops});
+            }
+        }
+
+        // Dijkstra from `source` among the remaining nodes, without `skipped`,
+        // until all `targets` marked nodes are settled, the next one is beyond
+        // `limit` or `budget` nodes are settled
+        void witnessSearch(NodeId source, NodeId skipped, double limit, size_t budget, size_t targets)
+        {
+            witness.begin(n);
+            witness.label(source, 0, NO_NODE);
+            IndexedDaryHeap<double> &open = witness.queue();
+            open.push(source, 0);
+            while (!open.empty() && open.topKey() <= limit && witness.settledCount() < budget)
+            {
+                NodeId v = open.pop();
+                witness.settle(v);
+                if (target[v] && --targets == 0)
+                    break;
+                for (const Arc &arc : out[v])
+                {
+                    if (arc.other == skipped)
+                        continue;
+                    double d = witness.distance(v) + arc.weight;
+                    if (!witness.reached(arc.other) || d < witness.distance(arc.other))
+                    {
+                        witness.label(arc.other, d, v);
+                        open.pushOrDecrease(arc.other, d);
+                    }
+                }
+            }
+        }
+
+        // Shortcuts needed to remove v: added if `apply`, otherwise only counted
+        Estimate shortcutsFor(NodeId v, bool apply)
+        {
+            Estimate needed;
+            for (size_t i = 0; i < in[v].size(); i++)
+            {
+                const Arc &incoming = in[v][i];
+                double limit = 0;
+                size_t targets = 0;
+                for (const Arc &outgoing : out[v])
+                {
+                    if (outgoing.other == incoming.other)
+                        continue;
+                    limit = std::max(limit, incoming.weight + outgoing.weight);
+                    target[outgoing.other] = 1;
+                    targets++;
+                }
+                if (targets == 0)
+                    continue;
+                witnessSearch(incoming.other, v, limit, apply ? witnessLimit : ESTIMATE_LIMIT, targets);
+                for (const Arc &outgoing : out[v])
+                    target[outgoing.other] = 0;
+                for (size_t j = 0; j < out[v].size(); j++)
+                {
+                    const Arc &outgoing = out[v][j];
+                    if (outgoing.other == incoming.other)
+                        continue;
+                    double viaV = incoming.weight + outgoing.weight;
+                    if (witness.reached(outgoing.other) && witness.distance(outgoing.other) <= viaV)
+                        continue; // a path at least as short avoids v
+                    needed.arcs++;
+                    needed.hops += incoming.hops + outgoing.hops;
+                    if (apply)
+                        addArc(incoming.other, outgoing.other, viaV, incoming.edge, outgoing.edge, incoming.hops + outgoing.hops);
+                }
+            }
+            return needed;
+        }
+
+        // Ratio of the arcs (and of the original arcs behind them) that removing
+        // v would add to those it would remove, plus the level of v: one more
+        // than the highest contracted neighbor. The ratios keep the graph sparse,
+        // the level spreads the contraction evenly and keeps the hierarchy flat.
+        double priority(NodeId v)
+        {
+            Estimate added = shortcutsFor(v, false);
+            size_t removed = in[v].size() + out[v].size();
+            size_t removedHops = 0;
+            for (const Arc &arc : in[v])
+                removedHops += arc.hops;
+            for (const Arc &arc : out[v])
+                removedHops += arc.hops;
+            if (removed == 0)
+                return level[v];
+            return level[v] + static_cast<double>(added.arcs) / removed + static_cast<double>(added.hops) / removedHops;
+        }
+
+        // Adds the shortcuts for v, then detaches v from the remaining nodes.
+        // v keeps its own arcs: they become its upward and downward arcs.
+        // Returns the number of shortcuts added.
+        size_t contract(NodeId v)
+        {
+            size_t added = shortcutsFor(v, true).arcs;
+            for (const Arc &arc : in[v])
+            {
+                auto &list = out[arc.other];
+                list.erase(std::remove_if(list.begin(), list.end(), [&](const Arc &a)
+                                          { return a.other == v; }),
+                           list.end());
+                level[arc.other] = std::max(level[arc.other], level[v] + 1);
+                changed[arc.other] = 1;
+            }
+            for (const Arc &arc : out[v])
+            {
+                auto &list = in[arc.other];
+                list.erase(std::remove_if(list.begin(), list.end(), [&](const Arc &a)
+                                          { return a.other == v; }),
+                           list.end());
+                level[arc.other] = std::max(level[arc.other], level[v] + 1);
+                changed[arc.other] = 1;
+            }
+            return added;
+        }
+    };
+};
+
+// Per-query state of a contraction hierarchy search; like SearchContext, one
+// per thread, reusable across queries on any hierarchy.
+class HierarchySearchContext
+{
+public:
+    // Shortest path from `start` to `goal`; returns false if there is none
+    bool query(const ContractionHierarchy &ch, NodeId start, NodeId goal)
+    {
+        hierarchy = &ch;
+        size_t n = ch.nodeCount();
+        forward.begin(n);
+        backward.begin(n);
+        best = HUGE_VAL;
+        meeting = NO_NODE;
+        forward.label(start, 0, NO_NODE);
+        forward.queue().push(start, 0);
+        backward.label(goal, 0, NO_NODE);
+        backward.queue().push(goal, 0);
+
+        // A direction is done once its smallest key cannot improve the best
+        // path; until both are, advance the one with the smaller key
+        for (;;)
+        {
+            bool forwardOpen = !forward.queue().empty() && forward.queue().topKey() < best;
+            bool backwardOpen = !backward.queue().empty() && backward.queue().topKey() < best;
+            if (!forwardOpen && !backwardOpen)
+                break;
+            if (forwardOpen && (!backwardOpen || forward.queue().topKey() <= backward.queue().topKey()))
+                step(forward, backward, ch.upward(), ch.downward());
+            else
+                step(backward, forward, ch.downward(), ch.upward());
+        }
+        return meeting != NO_NODE;
+    }
+
+    double distance() const
+    {
+        return best;
+    }
+
+    size_t settledCount() const
+    {
+        return forward.settledCount() + backward.settledCount();
+    }
+
+    // Nodes of the original graph from start to goal, shortcuts unpacked
+    std::vector<NodeId> path() const
+    {
+        std::vector<NodeId> nodes;
+        if (meeting == NO_NODE)
+            return nodes;
+
+        // Upward arcs from the start to the meeting node, found by walking back
+        std::vector<uint32_t> upArcs;
+        for (NodeId v = meeting; forward.parent(v) != NO_NODE; v = forward.parent(v))
+            upArcs.push_back(findArc(hierarchy->upward(), forward.parent(v), v));
+        NodeId start = meeting;
+        while (forward.parent(start) != NO_NODE)
+            start = forward.parent(start);
+        nodes.push_back(start);
+        for (auto a = upArcs.rbegin(); a != upArcs.rend(); ++a)
+            hierarchy->unpack(hierarchy->upwardEdge(*a), nodes);
+
+        // Downward arcs from the meeting node to the goal
+        for (NodeId v = meeting; backward.parent(v) != NO_NODE; v = backward.parent(v))
+            hierarchy->unpack(hierarchy->downwardEdge(findArc(hierarchy->downward(), backward.parent(v), v)), nodes);
+        return nodes;
+    }
+
+private:
+    const ContractionHierarchy *hierarchy = nullptr;
+    SearchContext forward;
+    SearchContext backward;
+    double best = HUGE_VAL;
+    NodeId meeting = NO_NODE;
+
+    // Settles the top node of `side`, which searches `graph`. `other` is the
+    // opposite search and `reverse` holds the arcs into each node from above in
+    // this search's direction, used to stall it.
+    void step(SearchContext &side, const SearchContext &other, const Graph &graph, const Graph &reverse)
+    {
+        NodeId v = side.queue().pop();
+        side.settle(v);
+        double d = side.distance(v);
+        if (other.reached(v) && d + other.distance(v) < best)
+        {
+            best = d + other.distance(v);
+            meeting = v;
+        }
+
+        // Stall-on-demand: if a higher node reaches v more cheaply, v is not on a
+        // shortest up-path and need not be expanded
+        for (uint32_t a = reverse.arcsBegin(v); a < reverse.arcsEnd(v); a++)
+        {
+            NodeId u = reverse.arcHead(a);
+            if (side.reached(u) && side.distance(u) + reverse.arcWeight(a) < d)
+                return;
+        }
+
+        for (uint32_t a = graph.arcsBegin(v); a < graph.arcsEnd(v); a++)
+        {
+            NodeId w = graph.arcHead(a);
+            double tentative = d + graph.arcWeight(a);
+            if (!side.reached(w) || tentative < side.distance(w))
+            {
+                side.label(w, tentative, v);
+                side.queue().pushOrDecrease(w, tentative);
+            }
+        }
+    }
+
+    // The arc tail -> head of a search graph (there is at most one per pair)
+    static uint32_t findArc(const Graph &graph, NodeId tail, NodeId head)
+    {
+        uint32_t a = graph.arcsBegin(tail);
+        while (graph.arcHead(a) != head)
+            a++;
+        return a;
+    }
+};
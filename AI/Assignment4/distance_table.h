@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "../common/thread_pool.h"
+#include "a_star.h"
+#include "graph.h"
+
+// Shortest distances from every source to every target, row-major:
+// at(i, j) is the distance from sources[i] to targets[j], HUGE_VAL if there is
+// no path.
+class DistanceTable
+{
+public:
+    DistanceTable() = default;
+
+    DistanceTable(size_t rows, size_t columns) : rowCount(rows), columnCount(columns), cells(rows * columns, HUGE_VAL) {}
+
+    size_t rows() const
+    {
+        return rowCount;
+    }
+
+    size_t columns() const
+    {
+        return columnCount;
+    }
+
+    double at(size_t row, size_t column) const
+    {
+        return cells[row * columnCount + column];
+    }
+
+    double *row(size_t r)
+    {
+        return &cells[r * columnCount];
+    }
+
+    const std::vector<double> &values() const
+    {
+        return cells;
+    }
+
+private:
+    size_t rowCount = 0;
+    size_t columnCount = 0;
+    std::vector<double> cells;
+};
+
+// Many-to-many shortest distances with one Dijkstra per source.
+// One search answers a whole row, where point-to-point A* would need one query
+// per cell. The searches only read the graph, so the rows are spread over a
+// thread pool, each worker reusing its own SearchContext. A search stops as
+// soon as all targets are settled instead of exploring the whole graph.
+class ManyToManySearch
+{
+public:
+    explicit ManyToManySearch(size_t threads = std::thread::hardware_concurrency())
+        : pool(threads), contexts(pool.size())
+    {
+    }
+
+    size_t threads() const
+    {
+        return pool.size();
+    }
+
+    // Must not be called from a task of this object's pool
+    DistanceTable compute(const Graph &graph, const std::vector<NodeId> &sources, const std::vector<NodeId> &targets)
+    {
+        DistanceTable table(sources.size(), targets.size());
+        if (sources.empty() || targets.empty())
+            return table;
+
+        // Marked once per call and shared read-only by the workers
+        size_t n = graph.nodeCount();
+        if (isTarget.size() < n)
+            isTarget.resize(n, 0);
+        size_t distinctTargets = 0;
+        for (NodeId t : targets)
+        {
+            if (!isTarget[t])
+            {
+                isTarget[t] = 1;
+                distinctTargets++;
+            }
+        }
+
+        pool.parallelFor(sources.size(), [&](size_t worker, size_t i)
+                         {
+                             SearchContext &context = contexts[worker];
+                             settleTargets(graph, context, sources[i], distinctTargets);
+                             double *row = table.row(i);
+                             for (size_t j = 0; j < targets.size(); j++)
+                             {
+                                 if (context.settled(targets[j]))
+                                     row[j] = context.distance(targets[j]);
+                             } });
+
+        for (NodeId t : targets)
+            isTarget[t] = 0;
+        return table;
+    }
+
+private:
+    ThreadPool pool;
+    std::vector<SearchContext> contexts; // one per worker
+    std::vector<char> isTarget;
+
+    // Dijkstra from `source` until `remaining` marked targets are settled or
+    // nothing reachable is left
+    void settleTargets(const Graph &graph, SearchContext &context, NodeId source, size_t remaining) const
+    {
+        context.begin(graph.nodeCount());
+        context.label(source, 0, NO_NODE);
+        IndexedDaryHeap<double> &open = context.queue();
+        open.push(source, 0);
+        while (!open.empty())
+        {
+            NodeId v = open.pop();
+            context.settle(v);
+            if (isTarget[v] && --remaining == 0)
+                return;
+            double g = context.distance(v);
+            for (uint32_t a = graph.arcsBegin(v); a < graph.arcsEnd(v); a++)
+            {
+                NodeId w = graph.arcHead(a);
+                double tentative = g + graph.arcWeight(a);
+                if (!context.reached(w) || tentative < context.distance(w))
+                {
+                    context.label(w, tentative, v);
+                    open.pushOrDecrease(w, tentative);
+                }
+            }
+        }
+    }
+};
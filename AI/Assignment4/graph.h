@@ -0,0 +1,468 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using NodeId = uint32_t;
+constexpr NodeId NO_NODE = std::numeric_limits<NodeId>::max();
+
+// Position of a node: planar x/y, or longitude/latitude in degrees
+struct Point
+{
+    double x;
+    double y;
+};
+
+// Immutable weighted directed graph in compressed sparse row (CSR) form.
+// The outgoing arcs of node v are arcs arcsBegin(v) .. arcsEnd(v) - 1.
+// Nothing changes after it is built, so one graph can be searched by any
+// number of threads at once.
+//
+// The accessors read through plain pointers. They point into the graph's own
+// arrays when it was built in memory, or straight into a mapped graph image
+// (see graph_image.h), in which case the graph owns no arrays at all and
+// copies share the mapping.
+class Graph
+{
+public:
+    Graph()
+    {
+        bindStorage();
+    }
+
+    Graph(const Graph &other)
+        : arcStart(other.arcStart), arcTarget(other.arcTarget), arcCost(other.arcCost), names(other.names),
+          ids(other.ids), points(other.points), image(other.image), view(other.view)
+    {
+        if (!image)
+            bindStorage();
+    }
+
+    Graph(Graph &&other) noexcept
+        : arcStart(std::move(other.arcStart)), arcTarget(std::move(other.arcTarget)), arcCost(std::move(other.arcCost)),
+          names(std::move(other.names)), ids(std::move(other.ids)), points(std::move(other.points)),
+          image(std::move(other.image)), view(other.view)
+    {
+        if (!image)
+            bindStorage();
+        other.clear();
+    }
+
+    Graph &operator=(const Graph &other)
+    {
+        if (this != &other)
+            *this = Graph(other);
+        return *this;
+    }
+
+    Graph &operator=(Graph &&other) noexcept
+    {
+        if (this != &other)
+        {
+            arcStart = std::move(other.arcStart);
+            arcTarget = std::move(other.arcTarget);
+            arcCost = std::move(other.arcCost);
+            names = std::move(other.names);
+            ids = std::move(other.ids);
+            points = std::move(other.points);
+            image = std::move(other.image);
+            view = other.view;
+            if (!image)
+                bindStorage();
+            other.clear();
+        }
+        return *this;
+    }
+
+    size_t nodeCount() const
+    {
+        return view.nodes;
+    }
+
+    size_t arcCount() const
+    {
+        return view.arcs;
+    }
+
+    uint32_t arcsBegin(NodeId v) const
+    {
+        return view.start[v];
+    }
+
+    uint32_t arcsEnd(NodeId v) const
+    {
+        return view.start[v + 1];
+    }
+
+    NodeId arcHead(uint32_t arc) const
+    {
+        return view.target[arc];
+    }
+
+    double arcWeight(uint32_t arc) const
+    {
+        return view.cost[arc];
+    }
+
+    bool hasNames() const
+    {
+        return image ? view.nameOffset != nullptr : !names.empty();
+    }
+
+    // Name of a node, or its number when the graph has no names
+    std::string name(NodeId v) const
+    {
+        if (!hasNames())
+            return std::to_string(v);
+        if (!image)
+            return names[v];
+        return std::string(view.nameChars + view.nameOffset[v], view.nameOffset[v + 1] - view.nameOffset[v]);
+    }
+
+    NodeId find(const std::string &nodeName) const
+    {
+        if (!image)
+        {
+            auto it = ids.find(nodeName);
+            return it == ids.end() ? NO_NODE : it->second;
+        }
+        if (!view.nameOffset)
+            return NO_NODE;
+
+        // Images keep the node ids sorted by name instead of a hash table
+        auto nameOf = [&](NodeId v)
+        {
+            return std::string_view(view.nameChars + view.nameOffset[v], view.nameOffset[v + 1] - view.nameOffset[v]);
+        };
+        const NodeId *end = view.nameOrder + view.nodes;
+        const NodeId *it = std::lower_bound(view.nameOrder, end, std::string_view(nodeName), [&](NodeId v, std::string_view key)
+                                            { return nameOf(v) < key; });
+        return it != end && nameOf(*it) == nodeName ? *it : NO_NODE;
+    }
+
+    bool hasCoordinates() const
+    {
+        return view.points != nullptr;
+    }
+
+    const Point &coordinate(NodeId v) const
+    {
+        return view.points[v];
+    }
+
+    // The same graph with every arc turned around, for searches towards a target
+    Graph reversed() const
+    {
+        Graph r;
+        size_t n = nodeCount();
+        r.arcStart.assign(n + 1, 0);
+        for (uint32_t a = 0; a < arcCount(); a++)
+            r.arcStart[arcHead(a) + 1]++;
+        for (size_t v = 0; v < n; v++)
+            r.arcStart[v + 1] += r.arcStart[v];
+        r.arcTarget.resize(arcCount());
+        r.arcCost.resize(arcCount());
+        std::vector<uint32_t> fill(r.arcStart.begin(), r.arcStart.end() - 1);
+        for (NodeId v = 0; v < n; v++)
+        {
+            for (uint32_t a = arcsBegin(v); a < arcsEnd(v); a++)
+            {
+                uint32_t slot = fill[arcHead(a)]++;
+                r.arcTarget[slot] = v;
+                r.arcCost[slot] = arcWeight(a);
+            }
+        }
+        if (hasNames())
+        {
+            for (NodeId v = 0; v < n; v++)
+            {
+                r.names.push_back(name(v));
+                r.ids.emplace(r.names.back(), v);
+            }
+        }
+        if (hasCoordinates())
+            r.points.assign(view.points, view.points + n);
+        r.bindStorage();
+        return r;
+    }
+
+private:
+    friend class GraphBuilder;
+    friend class GraphImage;
+
+    // Arrays of a graph built in memory (empty for a mapped image)
+    std::vector<uint32_t> arcStart{0};
+    std::vector<NodeId> arcTarget;
+    std::vector<double> arcCost;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, NodeId> ids;
+    std::vector<Point> points;
+
+    // Keeps a mapped image alive; null for a graph built in memory
+    std::shared_ptr<const void> image;
+
+    // What the accessors read
+    struct View
+    {
+        size_t nodes = 0;
+        size_t arcs = 0;
+        const uint32_t *start = nullptr;
+        const NodeId *target = nullptr;
+        const double *cost = nullptr;
+        const Point *points = nullptr;
+        const uint64_t *nameOffset = nullptr; // images only: name of v is chars [nameOffset[v], nameOffset[v + 1])
+        const char *nameChars = nullptr;
+        const NodeId *nameOrder = nullptr; // images only: node ids sorted by name
+    } view;
+
+    // Points the view at the graph's own arrays
+    void bindStorage()
+    {
+        view = View();
+        view.nodes = arcStart.empty() ? 0 : arcStart.size() - 1;
+        view.arcs = arcTarget.size();
+        view.start = arcStart.data();
+        view.target = arcTarget.data();
+        view.cost = arcCost.data();
+        view.points = points.empty() ? nullptr : points.data();
+    }
+
+    // Leaves a moved-from graph empty but usable
+    void clear()
+    {
+        arcStart.assign(1, 0);
+        arcTarget.clear();
+        arcCost.clear();
+        names.clear();
+        ids.clear();
+        points.clear();
+        image.reset();
+        bindStorage();
+    }
+};
+
+// Collects nodes and arcs, then lays them out as a Graph.
+// Arcs are kept as separate source/target/cost arrays. When they were added in
+// order of their source node (as most road network files are) the target and
+// cost arrays are already in CSR order, and an rvalue builder hands them to the
+// graph without sorting or copying.
+class GraphBuilder
+{
+public:
+    // Returns the id of a named node, creating it if needed
+    NodeId node(const std::string &name)
+    {
+        auto it = ids.find(name);
+        if (it != ids.end())
+            return it->second;
+        NodeId id = static_cast<NodeId>(names.size());
+        ids.emplace(name, id);
+        names.push_back(name);
+        nodes = std::max<size_t>(nodes, names.size());
+        return id;
+    }
+
+    // Makes sure ids 0 .. count - 1 exist (for graphs without names)
+    void reserveNodes(size_t count)
+    {
+        nodes = std::max(nodes, count);
+    }
+
+    void reserveArcs(size_t count)
+    {
+        arcFrom.reserve(count);
+        arcTo.reserve(count);
+        arcCost.reserve(count);
+    }
+
+    void addArc(NodeId from, NodeId to, double cost)
+    {
+        if (!arcFrom.empty() && from < arcFrom.back())
+            sortedBySource = false;
+        arcFrom.push_back(from);
+        arcTo.push_back(to);
+        arcCost.push_back(cost);
+        nodes = std::max<size_t>(nodes, std::max(from, to) + size_t(1));
+    }
+
+    void addEdge(NodeId a, NodeId b, double cost)
+    {
+        addArc(a, b, cost);
+        addArc(b, a, cost);
+    }
+
+    void setCoordinate(NodeId v, double x, double y)
+    {
+        if (points.size() <= v)
+            points.resize(v + size_t(1), Point{0, 0});
+        points[v] = {x, y};
+        nodes = std::max<size_t>(nodes, v + size_t(1));
+    }
+
+    size_t nodeCount() const
+    {
+        return nodes;
+    }
+
+    size_t arcCount() const
+    {
+        return arcFrom.size();
+    }
+
+    // Builds a graph and keeps the builder usable for more changes
+    Graph build() const &
+    {
+        Graph g;
+        layOut(g, arcTo, arcCost);
+        g.names = names;
+        g.ids = ids;
+        g.points = points;
+        finishNodes(g);
+        return g;
+    }
+
+    // Builds a graph from a builder that is not needed anymore, reusing its storage
+    Graph build() &&
+    {
+        Graph g;
+        if (sortedBySource)
+        {
+            countArcs(g);
+            g.arcTarget = std::move(arcTo);
+            g.arcCost = std::move(arcCost);
+        }
+        else
+        {
+            layOut(g, arcTo, arcCost);
+        }
+        std::vector<NodeId>().swap(arcFrom);
+        g.names = std::move(names);
+        g.ids = std::move(ids);
+        g.points = std::move(points);
+        finishNodes(g);
+        return g;
+    }
+
+private:
+    std::vector<NodeId> arcFrom;
+    std::vector<NodeId> arcTo;
+    std::vector<double> arcCost;
+    bool sortedBySource = true;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, NodeId> ids;
+    std::vector<Point> points;
+    size_t nodes = 0;
+
+    // Offsets from the number of arcs leaving every node
+    void countArcs(Graph &g) const
+    {
+        g.arcStart.assign(nodes + 1, 0);
+        for (NodeId from : arcFrom)
+            g.arcStart[from + 1]++;
+        for (size_t v = 0; v < nodes; v++)
+            g.arcStart[v + 1] += g.arcStart[v];
+    }
+
+    // Counting sort of the arcs by source node: O(V + E)
+    void layOut(Graph &g, const std::vector<NodeId> &to, const std::vector<double> &cost) const
+    {
+        countArcs(g);
+        g.arcTarget.resize(arcFrom.size());
+        g.arcCost.resize(arcFrom.size());
+        std::vector<uint32_t> fill(g.arcStart.begin(), g.arcStart.end() - 1);
+        for (size_t a = 0; a < arcFrom.size(); a++)
+        {
+            uint32_t slot = fill[arcFrom[a]]++;
+            g.arcTarget[slot] = to[a];
+            g.arcCost[slot] = cost[a];
+        }
+    }
+
+    // Names and coordinates cover every node, if there are any; then the
+    // graph's view is pointed at its arrays
+    void finishNodes(Graph &g) const
+    {
+        if (!g.names.empty())
+        {
+            for (size_t v = g.names.size(); v < nodes; v++)
+                g.names.push_back(std::to_string(v));
+        }
+        if (!g.points.empty())
+            g.points.resize(nodes, Point{0, 0});
+        g.bindStorage();
+    }
+};
+
+// --- Benchmark generators ---
+
+// A road-like network: `nodes` points scattered over a square of about one
+// unit of area per point, each joined by an undirected edge to its
+// `neighbors` nearest points (searched among the nearby buckets of a grid).
+// Edge costs are the planar length times a random detour factor of 1 .. 1.3,
+// so coordinates give an admissible heuristic with Metric::Euclidean.
+inline Graph makeRoadNetwork(size_t nodes, size_t neighbors, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    double side = std::sqrt(static_cast<double>(nodes));
+    std::uniform_real_distribution<double> coordinate(0, side);
+    std::vector<Point> points(nodes);
+    for (auto &p : points)
+        p = {coordinate(rng), coordinate(rng)};
+
+    // Buckets of about two points each
+    size_t cells = std::max<size_t>(1, static_cast<size_t>(std::sqrt(nodes / 2.0)));
+    auto bucketOf = [&](double c)
+    { return std::min(cells - 1, static_cast<size_t>(c / side * cells)); };
+    std::vector<uint32_t> bucketStart(cells * cells + 1, 0), bucketNodes(nodes);
+    for (const Point &p : points)
+        bucketStart[bucketOf(p.y) * cells + bucketOf(p.x) + 1]++;
+    for (size_t b = 0; b < cells * cells; b++)
+        bucketStart[b + 1] += bucketStart[b];
+    std::vector<uint32_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+    for (NodeId v = 0; v < nodes; v++)
+        bucketNodes[fill[bucketOf(points[v].y) * cells + bucketOf(points[v].x)]++] = v;
+
+    std::vector<std::pair<NodeId, NodeId>> edges;
+    std::vector<std::pair<double, NodeId>> candidates;
+    for (NodeId v = 0; v < nodes; v++)
+    {
+        candidates.clear();
+        size_t bx = bucketOf(points[v].x), by = bucketOf(points[v].y);
+        for (size_t y = by > 0 ? by - 1 : 0; y <= std::min(cells - 1, by + 1); y++)
+        {
+            for (size_t x = bx > 0 ? bx - 1 : 0; x <= std::min(cells - 1, bx + 1); x++)
+            {
+                for (uint32_t i = bucketStart[y * cells + x]; i < bucketStart[y * cells + x + 1]; i++)
+                {
+                    NodeId w = bucketNodes[i];
+                    if (w != v)
+                        candidates.push_back({std::hypot(points[w].x - points[v].x, points[w].y - points[v].y), w});
+                }
+            }
+        }
+        size_t k = std::min(neighbors, candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end());
+        for (size_t i = 0; i < k; i++)
+            edges.push_back({std::min(v, candidates[i].second), std::max(v, candidates[i].second)});
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    GraphBuilder builder;
+    builder.reserveNodes(nodes);
+    builder.reserveArcs(2 * edges.size());
+    std::uniform_real_distribution<double> detour(1.0, 1.3);
+    for (auto [a, b] : edges)
+        builder.addEdge(a, b, std::hypot(points[a].x - points[b].x, points[a].y - points[b].y) * detour(rng));
+    for (NodeId v = 0; v < nodes; v++)
+        builder.setCoordinate(v, points[v].x, points[v].y);
+    return std::move(builder).build();
+}
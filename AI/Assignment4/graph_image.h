@@ -0,0 +1,288 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "graph.h"
+
+// A whole file mapped read-only into memory. The pages are loaded on first
+// touch and shared with every other process that maps the same file.
+class MappedFile
+{
+public:
+    static std::shared_ptr<const MappedFile> open(const std::string &path)
+    {
+        std::shared_ptr<MappedFile> file(new MappedFile());
+#if defined(_WIN32)
+        file->handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file->handle == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("cannot open " + path);
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file->handle, &size))
+            throw std::runtime_error("cannot read the size of " + path);
+        file->length = static_cast<size_t>(size.QuadPart);
+        if (file->length == 0)
+            return file;
+        file->mapping = CreateFileMappingA(file->handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!file->mapping)
+            throw std::runtime_error("cannot map " + path);
+        file->bytes = MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!file->bytes)
+            throw std::runtime_error("cannot map " + path);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("cannot open " + path);
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("cannot read the size of " + path);
+        }
+        file->length = static_cast<size_t>(info.st_size);
+        if (file->length > 0)
+        {
+            void *bytes = mmap(nullptr, file->length, PROT_READ, MAP_SHARED, fd, 0);
+            if (bytes != MAP_FAILED)
+                file->bytes = bytes;
+        }
+        ::close(fd); // the mapping stays valid without the descriptor
+        if (file->length > 0 && !file->bytes)
+            throw std::runtime_error("cannot map " + path);
+#endif
+        return file;
+    }
+
+    ~MappedFile()
+    {
+#if defined(_WIN32)
+        if (bytes)
+            UnmapViewOfFile(bytes);
+        if (mapping)
+            CloseHandle(mapping);
+        if (handle != INVALID_HANDLE_VALUE)
+            CloseHandle(handle);
+#else
+        if (bytes)
+            munmap(bytes, length);
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const
+    {
+        return static_cast<const char *>(bytes);
+    }
+
+    size_t size() const
+    {
+        return length;
+    }
+
+private:
+    MappedFile() = default;
+
+    void *bytes = nullptr;
+    size_t length = 0;
+#if defined(_WIN32)
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+// Binary graph image: everything a Graph reads, laid out so that a mapped
+// file can be searched in place, with no parsing and no allocation.
+//
+// Layout: a fixed header, then one section per array, each starting at a
+// multiple of 64 bytes: CSR offsets (uint32, nodes + 1), arc targets (uint32),
+// arc weights (double), and optionally coordinates (two doubles per node) and
+// a name table: per-node offsets into the name characters (uint64, nodes + 1),
+// the characters, and the node ids sorted by name for find(). Numbers are in
+// the byte order of the machine that wrote the image; the header records it
+// so a mismatch is reported instead of misread.
+class GraphImage
+{
+public:
+    // Compiles `graph` into an image file
+    static void write(const Graph &graph, const std::string &path)
+    {
+        size_t n = graph.nodeCount(), m = graph.arcCount();
+        std::vector<uint64_t> nameOffset;
+        std::string nameChars;
+        std::vector<NodeId> nameOrder;
+        if (graph.hasNames())
+        {
+            nameOffset.reserve(n + 1);
+            nameOffset.push_back(0);
+            for (NodeId v = 0; v < n; v++)
+            {
+                nameChars += graph.name(v);
+                nameOffset.push_back(nameChars.size());
+            }
+            nameOrder.resize(n);
+            std::iota(nameOrder.begin(), nameOrder.end(), NodeId(0));
+            auto nameOf = [&](NodeId v)
+            { return std::string_view(nameChars.data() + nameOffset[v], nameOffset[v + 1] - nameOffset[v]); };
+            std::sort(nameOrder.begin(), nameOrder.end(), [&](NodeId a, NodeId b)
+                      { return nameOf(a) < nameOf(b); });
+        }
+
+        Header header = {};
+        std::memcpy(header.magic, MAGIC, sizeof header.magic);
+        header.version = VERSION;
+        header.byteOrder = BYTE_ORDER_MARK;
+        header.nodes = n;
+        header.arcs = m;
+        uint64_t end = align(sizeof(Header));
+        auto place = [&](uint64_t &offset, uint64_t bytes, bool present)
+        {
+            offset = present ? end : 0;
+            if (present)
+                end = align(end + bytes);
+        };
+        place(header.start, (n + 1) * sizeof(uint32_t), true);
+        place(header.target, m * sizeof(NodeId), true);
+        place(header.cost, m * sizeof(double), true);
+        place(header.points, n * sizeof(Point), graph.hasCoordinates());
+        place(header.nameOffset, nameOffset.size() * sizeof(uint64_t), graph.hasNames());
+        place(header.nameChars, nameChars.size(), graph.hasNames());
+        place(header.nameOrder, nameOrder.size() * sizeof(NodeId), graph.hasNames());
+        header.nameBytes = nameChars.size();
+        header.fileSize = end;
+
+        std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(path.c_str(), "wb"), std::fclose);
+        if (!file)
+            throw std::runtime_error("cannot write " + path);
+        uint64_t written = 0;
+        bool ok = true;
+        auto put = [&](uint64_t offset, const void *data, uint64_t bytes)
+        {
+            static const char zeros[ALIGNMENT] = {};
+            while (ok && written < offset)
+            {
+                size_t pad = static_cast<size_t>(std::min<uint64_t>(offset - written, ALIGNMENT));
+                ok = std::fwrite(zeros, 1, pad, file.get()) == pad;
+                written += pad;
+            }
+            if (ok && bytes > 0)
+                ok = std::fwrite(data, 1, bytes, file.get()) == bytes;
+            written += bytes;
+        };
+        put(0, &header, sizeof header);
+        put(header.start, graph.view.start, (n + 1) * sizeof(uint32_t));
+        put(header.target, graph.view.target, m * sizeof(NodeId));
+        put(header.cost, graph.view.cost, m * sizeof(double));
+        if (graph.hasCoordinates())
+            put(header.points, graph.view.points, n * sizeof(Point));
+        if (graph.hasNames())
+        {
+            put(header.nameOffset, nameOffset.data(), nameOffset.size() * sizeof(uint64_t));
+            put(header.nameChars, nameChars.data(), nameChars.size());
+            put(header.nameOrder, nameOrder.data(), nameOrder.size() * sizeof(NodeId));
+        }
+        put(header.fileSize, nullptr, 0);
+        if (!ok)
+            throw std::runtime_error("error writing " + path);
+    }
+
+    // Maps an image written by write(). Only the header and the section bounds
+    // are checked; the arrays themselves are used as they are.
+    static Graph map(const std::string &path)
+    {
+        std::shared_ptr<const MappedFile> file = MappedFile::open(path);
+        Header header;
+        if (file->size() < sizeof header)
+            throw std::runtime_error(path + " is not a graph image");
+        std::memcpy(&header, file->data(), sizeof header);
+        if (std::memcmp(header.magic, MAGIC, sizeof header.magic) != 0)
+            throw std::runtime_error(path + " is not a graph image");
+        if (header.byteOrder != BYTE_ORDER_MARK)
+            throw std::runtime_error(path + " was written on a machine with another byte order");
+        if (header.version != VERSION)
+            throw std::runtime_error(path + " has unsupported version " + std::to_string(header.version));
+        if (header.fileSize != file->size())
+            throw std::runtime_error(path + " is truncated");
+        if (header.nodes >= NO_NODE || header.arcs > UINT32_MAX)
+            throw std::runtime_error(path + " is too large for 32-bit node and arc ids");
+
+        size_t n = static_cast<size_t>(header.nodes), m = static_cast<size_t>(header.arcs);
+        auto section = [&](uint64_t offset, uint64_t bytes, bool required) -> const char *
+        {
+            if (offset == 0 && !required)
+                return nullptr;
+            if (offset == 0 || offset % ALIGNMENT != 0 || offset > file->size() || bytes > file->size() - offset)
+                throw std::runtime_error(path + " has a damaged section table");
+            return file->data() + offset;
+        };
+
+        Graph g;
+        Graph::View &view = g.view;
+        view.nodes = n;
+        view.arcs = m;
+        view.start = reinterpret_cast<const uint32_t *>(section(header.start, (n + 1) * sizeof(uint32_t), true));
+        view.target = reinterpret_cast<const NodeId *>(section(header.target, m * sizeof(NodeId), true));
+        view.cost = reinterpret_cast<const double *>(section(header.cost, m * sizeof(double), true));
+        view.points = reinterpret_cast<const Point *>(section(header.points, n * sizeof(Point), false));
+        view.nameOffset = reinterpret_cast<const uint64_t *>(section(header.nameOffset, (n + 1) * sizeof(uint64_t), false));
+        if (view.nameOffset)
+        {
+            view.nameChars = section(header.nameChars, header.nameBytes, true);
+            view.nameOrder = reinterpret_cast<const NodeId *>(section(header.nameOrder, n * sizeof(NodeId), true));
+            if (view.nameOffset[n] != header.nameBytes)
+                throw std::runtime_error(path + " has a damaged name table");
+        }
+        if (view.start[0] != 0 || view.start[n] != m)
+            throw std::runtime_error(path + " has damaged arc offsets");
+        g.image = file;
+        return g;
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'C', 'S', 'R', 'G', 'R', 'A', 'P', 'H'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    static constexpr size_t ALIGNMENT = 64;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t nodes;
+        uint64_t arcs;
+        uint64_t nameBytes;
+        uint64_t fileSize;
+        // Byte offsets of the sections; 0 for the optional ones that are absent
+        uint64_t start;
+        uint64_t target;
+        uint64_t cost;
+        uint64_t points;
+        uint64_t nameOffset;
+        uint64_t nameChars;
+        uint64_t nameOrder;
+    };
+
+    static uint64_t align(uint64_t offset)
+    {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+};
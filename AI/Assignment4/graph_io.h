@@ -0,0 +1,197 @@
+#pragma once
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "graph.h"
+
+// Reads a text file in large blocks and hands out one line at a time,
+// without allocating per line.
+class LineReader
+{
+public:
+    explicit LineReader(const std::string &path) : path(path), file(std::fopen(path.c_str(), "rb")), buffer(1 << 22)
+    {
+        if (!file)
+            throw std::runtime_error("cannot open " + path);
+    }
+
+    ~LineReader()
+    {
+        std::fclose(file);
+    }
+
+    LineReader(const LineReader &) = delete;
+    LineReader &operator=(const LineReader &) = delete;
+
+    // Sets [begin, end) to the next line without its line break; false at end of file
+    bool next(const char *&begin, const char *&end)
+    {
+        for (;;)
+        {
+            char *newline = static_cast<char *>(std::memchr(buffer.data() + head, '\n', tail - head));
+            if (newline || (eof && head < tail))
+            {
+                begin = buffer.data() + head;
+                end = newline ? newline : buffer.data() + tail;
+                head = static_cast<size_t>(end - buffer.data()) + (newline ? 1 : 0);
+                if (end > begin && end[-1] == '\r')
+                    end--;
+                line++;
+                return true;
+            }
+            if (eof)
+                return false;
+            refill();
+        }
+    }
+
+    // Number of the line last returned, starting at 1
+    size_t lineNumber() const
+    {
+        return line;
+    }
+
+    // Error message that points at the current line
+    std::runtime_error error(const std::string &what) const
+    {
+        return std::runtime_error(path + ":" + std::to_string(line) + ": " + what);
+    }
+
+private:
+    std::string path;
+    std::FILE *file;
+    std::vector<char> buffer;
+    size_t head = 0; // first unread byte
+    size_t tail = 0; // end of the data in the buffer
+    size_t line = 0;
+    bool eof = false;
+
+    // Moves the partial line to the front and reads the next block behind it
+    void refill()
+    {
+        std::memmove(buffer.data(), buffer.data() + head, tail - head);
+        tail -= head;
+        head = 0;
+        if (tail == buffer.size())
+            buffer.resize(buffer.size() * 2); // a line longer than the buffer
+        size_t got = std::fread(buffer.data() + tail, 1, buffer.size() - tail, file);
+        tail += got;
+        if (got == 0)
+            eof = true;
+    }
+};
+
+// Field parsing on [p, end): skips leading blanks and separators, then parses
+// one number and advances p past it. Returns false if there is no number.
+inline void skipSeparators(const char *&p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == ','))
+        p++;
+}
+
+template <class Number>
+bool parseField(const char *&p, const char *end, Number &value)
+{
+    skipSeparators(p, end);
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc())
+        return false;
+    p = result.ptr;
+    return true;
+}
+
+// Loads a road network in the format of the 9th DIMACS Implementation
+// Challenge. The .gr file holds "p sp <nodes> <arcs>" and one "a <from> <to>
+// <weight>" line per directed arc, with nodes numbered from 1. The optional .co
+// file holds "v <node> <longitude> <latitude>" lines in millionths of a degree.
+// Nodes are renumbered from 0.
+inline Graph loadDimacs(const std::string &grPath, const std::string &coPath = "")
+{
+    GraphBuilder builder;
+    const char *begin, *end;
+    {
+        LineReader reader(grPath);
+        while (reader.next(begin, end))
+        {
+            if (begin == end || *begin == 'c')
+                continue;
+            const char *p = begin + 1;
+            if (*begin == 'a')
+            {
+                uint32_t from, to;
+                double weight;
+                if (!parseField(p, end, from) || !parseField(p, end, to) || !parseField(p, end, weight) || from == 0 || to == 0)
+                    throw reader.error("malformed arc line");
+                builder.addArc(from - 1, to - 1, weight);
+            }
+            else if (*begin == 'p')
+            {
+                // "p sp <nodes> <arcs>"
+                while (p < end && (*p == ' ' || (*p >= 'a' && *p <= 'z')))
+                    p++;
+                size_t nodes, arcs;
+                if (!parseField(p, end, nodes) || !parseField(p, end, arcs))
+                    throw reader.error("malformed problem line");
+                builder.reserveNodes(nodes);
+                builder.reserveArcs(arcs);
+            }
+            else
+            {
+                throw reader.error("unknown line type");
+            }
+        }
+    }
+
+    if (!coPath.empty())
+    {
+        LineReader reader(coPath);
+        while (reader.next(begin, end))
+        {
+            if (begin == end || *begin == 'c' || *begin == 'p')
+                continue;
+            const char *p = begin + 1;
+            uint32_t node;
+            double x, y;
+            if (*begin != 'v' || !parseField(p, end, node) || !parseField(p, end, x) || !parseField(p, end, y) || node == 0)
+                throw reader.error("malformed coordinate line");
+            builder.setCoordinate(node - 1, x / 1e6, y / 1e6);
+        }
+    }
+    return std::move(builder).build();
+}
+
+// Loads a plain edge list with one "<from>,<to>,<weight>" line per edge and
+// nodes numbered from 0. A first line that does not start with a number is
+// taken as a header; lines starting with '#' are comments. Undirected lists
+// get an arc in each direction.
+inline Graph loadCsvEdges(const std::string &path, bool undirected = false)
+{
+    GraphBuilder builder;
+    LineReader reader(path);
+    const char *begin, *end;
+    while (reader.next(begin, end))
+    {
+        const char *p = begin;
+        skipSeparators(p, end);
+        if (p == end || *p == '#')
+            continue;
+        uint32_t from, to;
+        double weight;
+        if (!parseField(p, end, from) || !parseField(p, end, to) || !parseField(p, end, weight))
+        {
+            if (reader.lineNumber() == 1)
+                continue; // header
+            throw reader.error("expected <from>,<to>,<weight>");
+        }
+        if (undirected)
+            builder.addEdge(from, to, weight);
+        else
+            builder.addArc(from, to, weight);
+    }
+    return std::move(builder).build();
+}
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "graph.h"
+#include "graph_io.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Index of the lowest / highest set bit; `bits` must not be 0
+inline int lowestBit(uint64_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+inline int highestBit(uint64_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(bits);
+#endif
+}
+
+// One bit per cell, 1 = passable, rows packed into 64-bit words.
+// Every row is padded with blocked cells on both sides and there is a blocked
+// row above and below, so neighbors and 64-cell spans can be read at the
+// border without range checks.
+class BitGrid
+{
+public:
+    BitGrid() = default;
+
+    BitGrid(int width, int height)
+        : stride((static_cast<size_t>(width) + 3 * PAD) / 64 + 1),
+          words(stride * (static_cast<size_t>(height) + 2), 0)
+    {
+    }
+
+    // Any x in [-1, width] and y in [-1, height] of a width x height grid
+    bool get(int x, int y) const
+    {
+        size_t bit = static_cast<size_t>(x + PAD);
+        return (words[row(y) + bit / 64] >> (bit % 64)) & 1;
+    }
+
+    void set(int x, int y, bool passable)
+    {
+        size_t bit = static_cast<size_t>(x + PAD);
+        uint64_t mask = uint64_t(1) << (bit % 64);
+        if (passable)
+            words[row(y) + bit / 64] |= mask;
+        else
+            words[row(y) + bit / 64] &= ~mask;
+    }
+
+    // Cells x .. x + 63 of row y, bit i for cell x + i; for x in [-128, width + 64]
+    uint64_t span(int x, int y) const
+    {
+        size_t bit = static_cast<size_t>(x + PAD);
+        const uint64_t *w = &words[row(y) + bit / 64];
+        unsigned shift = bit % 64;
+        return shift == 0 ? w[0] : (w[0] >> shift) | (w[1] << (64 - shift));
+    }
+
+private:
+    static constexpr int PAD = 128; // blocked cells left of x = 0
+
+    size_t stride = 0; // words per row
+    std::vector<uint64_t> words;
+
+    size_t row(int y) const
+    {
+        return static_cast<size_t>(y + 1) * stride;
+    }
+};
+
+// 2D occupancy grid with 8-connected moves: straight moves cost 1, diagonal
+// ones sqrt(2), and a diagonal move may not cut a corner (both cells it
+// passes between must be free), as in the MovingAI benchmarks.
+// Cells are numbered y * width + x, so they can be used as NodeIds.
+// The bits are kept twice, by rows and by columns, so searches can scan
+// along both axes a word at a time.
+class GridMap
+{
+public:
+    static constexpr double DIAGONAL = 1.4142135623730951;
+
+    GridMap() = default;
+
+    // All cells blocked
+    GridMap(int width, int height) : w(width), h(height), rowBits(width, height), columnBits(height, width) {}
+
+    // Loads a map in the MovingAI format: a "type", "height" and "width" header,
+    // then "map" and one line of characters per row. '.', 'G' and 'S' are
+    // passable, everything else is blocked.
+    static GridMap loadMovingAI(const std::string &path)
+    {
+        LineReader reader(path);
+        const char *begin, *end;
+        int width = -1, height = -1;
+        while (reader.next(begin, end))
+        {
+            std::string line(begin, end);
+            if (line.compare(0, 6, "height") == 0)
+                height = std::atoi(line.c_str() + 6);
+            else if (line.compare(0, 5, "width") == 0)
+                width = std::atoi(line.c_str() + 5);
+            else if (line.compare(0, 3, "map") == 0)
+                break;
+        }
+        if (width <= 0 || height <= 0)
+            throw reader.error("missing width or height");
+
+        GridMap map(width, height);
+        for (int y = 0; y < height; y++)
+        {
+            if (!reader.next(begin, end) || end - begin < width)
+                throw reader.error("expected " + std::to_string(width) + " cells");
+            for (int x = 0; x < width; x++)
+            {
+                char c = begin[x];
+                if (c == '.' || c == 'G' || c == 'S')
+                    map.setPassable(x, y, true);
+            }
+        }
+        return map;
+    }
+
+    int width() const
+    {
+        return w;
+    }
+
+    int height() const
+    {
+        return h;
+    }
+
+    size_t cellCount() const
+    {
+        return static_cast<size_t>(w) * h;
+    }
+
+    NodeId cell(int x, int y) const
+    {
+        return static_cast<NodeId>(y) * w + x;
+    }
+
+    int x(NodeId cell) const
+    {
+        return static_cast<int>(cell % w);
+    }
+
+    int y(NodeId cell) const
+    {
+        return static_cast<int>(cell / w);
+    }
+
+    // False outside the map
+    bool passable(int x, int y) const
+    {
+        return x >= -1 && x <= w && y >= -1 && y <= h && rowBits.get(x, y);
+    }
+
+    void setPassable(int x, int y, bool passable)
+    {
+        rowBits.set(x, y, passable);
+        columnBits.set(y, x, passable);
+    }
+
+    // Whether a move by (dx, dy) from a passable cell is allowed
+    bool canMove(int x, int y, int dx, int dy) const
+    {
+        if (!passable(x + dx, y + dy))
+            return false;
+        return dx == 0 || dy == 0 || (passable(x + dx, y) && passable(x, y + dy));
+    }
+
+    // Bits by row: span(x, y) covers cells x .. x + 63 of row y
+    const BitGrid &rows() const
+    {
+        return rowBits;
+    }
+
+    // Bits by column: span(y, x) covers cells y .. y + 63 of column x
+    const BitGrid &columns() const
+    {
+        return columnBits;
+    }
+
+    // Shortest distance when nothing is in the way
+    static double octile(int dx, int dy)
+    {
+        dx = std::abs(dx);
+        dy = std::abs(dy);
+        return std::max(dx, dy) + (DIAGONAL - 1) * std::min(dx, dy);
+    }
+
+    // Octile distance from a cell to `goal`; also works on toGraph(), which
+    // keeps the cell numbers
+    struct Towards
+    {
+        const GridMap *map;
+        NodeId goal;
+
+        double operator()(NodeId v) const
+        {
+            return octile(map->x(v) - map->x(goal), map->y(v) - map->y(goal));
+        }
+    };
+
+    Towards towards(NodeId goal) const
+    {
+        return {this, goal};
+    }
+
+    // The same map as an explicit graph with one arc per allowed move
+    Graph toGraph() const
+    {
+        GraphBuilder builder;
+        builder.reserveNodes(cellCount());
+        for (int y = 0; y < h; y++)
+        {
+            for (int x = 0; x < w; x++)
+            {
+                if (!passable(x, y))
+                    continue;
+                for (int dy = -1; dy <= 1; dy++)
+                {
+                    for (int dx = -1; dx <= 1; dx++)
+                    {
+                        if ((dx != 0 || dy != 0) && canMove(x, y, dx, dy))
+                            builder.addArc(cell(x, y), cell(x + dx, y + dy), dx != 0 && dy != 0 ? DIAGONAL : 1);
+                    }
+                }
+            }
+        }
+        return std::move(builder).build();
+    }
+
+private:
+    int w = 0;
+    int h = 0;
+    BitGrid rowBits;
+    BitGrid columnBits;
+};
+
+// One query of a MovingAI scenario file
+struct GridScenario
+{
+    int startX, startY, goalX, goalY;
+    double optimalLength;
+};
+
+// Loads a MovingAI .scen file: "version 1", then one tab-separated line per
+// query: bucket, map, width, height, start x, start y, goal x, goal y, length
+inline std::vector<GridScenario> loadScenarios(const std::string &path)
+{
+    LineReader reader(path);
+    std::vector<GridScenario> scenarios;
+    const char *begin, *end;
+    while (reader.next(begin, end))
+    {
+        if (begin == end || std::strncmp(begin, "version", std::min<size_t>(7, end - begin)) == 0)
+            continue;
+        // Skip the bucket and the map name
+        const char *p = begin;
+        for (int tabs = 0; tabs < 2 && p < end; p++)
+        {
+            if (*p == '\t')
+                tabs++;
+        }
+        int width, height;
+        GridScenario s;
+        if (!parseField(p, end, width) || !parseField(p, end, height) || !parseField(p, end, s.startX) ||
+            !parseField(p, end, s.startY) || !parseField(p, end, s.goalX) || !parseField(p, end, s.goalY) ||
+            !parseField(p, end, s.optimalLength))
+            throw reader.error("malformed scenario line");
+        scenarios.push_back(s);
+    }
+    return scenarios;
+}
+
+// --- Benchmark generators ---
+
+// A width x height map where every cell is blocked with probability `obstacles`
+inline GridMap makeRandomGridMap(int width, int height, double obstacles, unsigned seed)
+{
+    GridMap map(width, height);
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution blocked(obstacles);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+            map.setPassable(x, y, !blocked(rng));
+    }
+    return map;
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "a_star.h"
+#include "grid_map.h"
+
+// Shortest paths on a GridMap without building a graph: neighbors come from
+// the bit grid on the fly, and the labels live in a SearchContext indexed by
+// cell number, so a context is reused across queries like any other.
+//
+// aStar() is plain A* over the 8 neighbors of every cell.
+//
+// jumpPointSearch() is Jump Point Search (Harabor and Grastien), in the
+// variant for maps without corner cutting. A grid has many shortest paths of
+// equal length that only differ in the order of their moves; JPS only follows
+// the one that goes diagonally first. From every expanded cell it scans ahead
+// in a straight line and skips all cells whose neighbors can be reached at
+// least as cheaply without them, stopping only at "jump points": cells next to
+// an obstacle corner where the canonical path may have to turn. Only jump
+// points enter the open list.
+//
+// Straight scans can test one cell per step, or 64 at a time on the packed
+// rows (and on the packed columns for vertical scans): a jump point is a cell
+// whose neighbor row is free while the cell behind that neighbor is blocked,
+// which is `side & ~(side shifted by one)` over a whole word.
+class GridSearch
+{
+public:
+    enum class Scan
+    {
+        Cellwise,
+        BitParallel
+    };
+
+    // Plain A* with the octile heuristic; false if `goal` cannot be reached
+    bool aStar(const GridMap &map, NodeId start, NodeId goal)
+    {
+        this->map = &map;
+        GridMap::Towards h = map.towards(goal);
+        context.begin(map.cellCount());
+        if (!startQuery(start, goal))
+            return false;
+        IndexedDaryHeap<double> &open = context.queue();
+        while (!open.empty())
+        {
+            NodeId current = open.pop();
+            context.settle(current);
+            if (current == goal)
+                return true;
+            int x = map.x(current), y = map.y(current);
+            for (int dy = -1; dy <= 1; dy++)
+            {
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    if ((dx != 0 || dy != 0) && map.canMove(x, y, dx, dy))
+                        relax(current, map.cell(x + dx, y + dy), dx != 0 && dy != 0 ? GridMap::DIAGONAL : 1, h);
+                }
+            }
+        }
+        return false;
+    }
+
+    // Jump Point Search with the octile heuristic; false if `goal` cannot be reached
+    bool jumpPointSearch(const GridMap &map, NodeId start, NodeId goal, Scan scan = Scan::BitParallel)
+    {
+        this->map = &map;
+        this->scan = scan;
+        goalX = map.x(goal);
+        goalY = map.y(goal);
+        GridMap::Towards h = map.towards(goal);
+        context.begin(map.cellCount());
+        if (!startQuery(start, goal))
+            return false;
+        IndexedDaryHeap<double> &open = context.queue();
+        while (!open.empty())
+        {
+            NodeId current = open.pop();
+            context.settle(current);
+            if (current == goal)
+                return true;
+            int x = map.x(current), y = map.y(current);
+            NodeId parent = context.parent(current);
+            if (parent == NO_NODE)
+            {
+                for (int dy = -1; dy <= 1; dy++)
+                {
+                    for (int dx = -1; dx <= 1; dx++)
+                    {
+                        if (dx != 0 || dy != 0)
+                            jumpFrom(current, x, y, dx, dy, h);
+                    }
+                }
+                continue;
+            }
+
+            // Direction of the jump that reached this cell
+            int dx = sign(x - map.x(parent)), dy = sign(y - map.y(parent));
+            if (dx != 0 && dy != 0)
+            {
+                // Diagonal: straight on along both axes, and diagonally on
+                jumpFrom(current, x, y, dx, 0, h);
+                jumpFrom(current, x, y, 0, dy, h);
+                jumpFrom(current, x, y, dx, dy, h);
+            }
+            else
+            {
+                // Straight: straight on, plus the forced turns around obstacle
+                // corners beside this cell (the perpendicular step and the
+                // diagonal one past it)
+                jumpFrom(current, x, y, dx, dy, h);
+                int px = dy, py = dx; // perpendicular
+                for (int side = -1; side <= 1; side += 2)
+                {
+                    int sx = px * side, sy = py * side;
+                    if (map.passable(x + sx, y + sy) && !map.passable(x - dx + sx, y - dy + sy))
+                    {
+                        jumpFrom(current, x, y, sx, sy, h);
+                        jumpFrom(current, x, y, dx + sx, dy + sy, h);
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    // --- Results of the last query ---
+
+    double distance(NodeId goal) const
+    {
+        return context.distance(goal);
+    }
+
+    size_t settledCount() const
+    {
+        return context.settledCount();
+    }
+
+    // Every cell from the start to `goal`; for JPS the cells between
+    // consecutive jump points are filled in
+    std::vector<NodeId> path(NodeId goal) const
+    {
+        std::vector<NodeId> points = context.path(goal);
+        std::vector<NodeId> cells;
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            if (i > 0)
+            {
+                int x = map->x(points[i - 1]), y = map->y(points[i - 1]);
+                int dx = sign(map->x(points[i]) - x), dy = sign(map->y(points[i]) - y);
+                for (x += dx, y += dy; map->cell(x, y) != points[i]; x += dx, y += dy)
+                    cells.push_back(map->cell(x, y));
+            }
+            cells.push_back(points[i]);
+        }
+        return cells;
+    }
+
+private:
+    static constexpr int NONE = std::numeric_limits<int>::min();
+
+    const GridMap *map = nullptr;
+    SearchContext context;
+    Scan scan = Scan::BitParallel;
+    int goalX = 0;
+    int goalY = 0;
+
+    static int sign(int v)
+    {
+        return (v > 0) - (v < 0);
+    }
+
+    bool startQuery(NodeId start, NodeId goal)
+    {
+        if (!map->passable(map->x(start), map->y(start)) || !map->passable(map->x(goal), map->y(goal)))
+            return false;
+        context.label(start, 0, NO_NODE);
+        context.queue().push(start, map->towards(goal)(start));
+        return true;
+    }
+
+    template <class Heuristic>
+    void relax(NodeId from, NodeId to, double cost, const Heuristic &h)
+    {
+        double tentative = context.distance(from) + cost;
+        if (!context.reached(to))
+        {
+            context.label(to, tentative, from);
+            context.queue().push(to, tentative + h(to));
+        }
+        else if (tentative < context.distance(to) && context.queue().contains(to))
+        {
+            double key = context.queue().key(to) - (context.distance(to) - tentative);
+            context.label(to, tentative, from);
+            context.queue().decreaseKey(to, key);
+        }
+    }
+
+    // Jumps from (x, y) in direction (dx, dy) and relaxes the jump point found
+    template <class Heuristic>
+    void jumpFrom(NodeId current, int x, int y, int dx, int dy, const Heuristic &h)
+    {
+        if (!map->canMove(x, y, dx, dy))
+            return;
+        int steps = dx != 0 && dy != 0 ? jumpDiagonal(x, y, dx, dy) : jumpStraight(x, y, dx, dy);
+        if (steps != NONE)
+            relax(current, map->cell(x + steps * dx, y + steps * dy), GridMap::octile(steps * dx, steps * dy), h);
+    }
+
+    // Number of diagonal steps from (x, y) to the next jump point, or NONE.
+    // A diagonal cell is a jump point if it is the goal or a straight scan
+    // from it along either axis finds one.
+    int jumpDiagonal(int x, int y, int dx, int dy) const
+    {
+        for (int steps = 1;; steps++)
+        {
+            x += dx;
+            y += dy;
+            if (x == goalX && y == goalY)
+                return steps;
+            if ((map->canMove(x, y, dx, 0) && jumpStraight(x, y, dx, 0) != NONE) ||
+                (map->canMove(x, y, 0, dy) && jumpStraight(x, y, 0, dy) != NONE))
+                return steps;
+            if (!map->canMove(x, y, dx, dy))
+                return NONE;
+        }
+    }
+
+    // Number of straight steps from (x, y) to the next jump point, or NONE if
+    // the scan runs into an obstacle first
+    int jumpStraight(int x, int y, int dx, int dy) const
+    {
+        // Vertical scans run along the columns of the transposed grid
+        const BitGrid &bits = dx != 0 ? map->rows() : map->columns();
+        int along = dx != 0 ? x : y, line = dx != 0 ? y : x, direction = dx != 0 ? dx : dy;
+        int goal = (dx != 0 ? goalY == y : goalX == x) ? (dx != 0 ? goalX : goalY) : NONE;
+        int found = scan == Scan::BitParallel ? scanWords(bits, along + direction, line, direction, goal)
+                                              : scanCells(bits, along + direction, line, direction, goal);
+        return found == NONE ? NONE : (found - along) * direction;
+    }
+
+    // First jump point at or after position `from` on line `line` moving by
+    // `direction`: the goal, or a cell with a free side neighbor whose cell
+    // behind is blocked. NONE if a blocked cell comes first.
+    static int scanCells(const BitGrid &bits, int from, int line, int direction, int goal)
+    {
+        for (int p = from;; p += direction)
+        {
+            if (!bits.get(p, line))
+                return NONE;
+            if (p == goal)
+                return p;
+            if ((bits.get(p, line - 1) && !bits.get(p - direction, line - 1)) ||
+                (bits.get(p, line + 1) && !bits.get(p - direction, line + 1)))
+                return p;
+        }
+    }
+
+    // The same scan 64 cells at a time
+    static int scanWords(const BitGrid &bits, int from, int line, int direction, int goal)
+    {
+        for (int p = from;; p += 64 * direction)
+        {
+            // Window of 64 cells ending (in scan order) at p + 63 * direction;
+            // `behind` is the same window shifted back by one cell
+            int base = direction > 0 ? p : p - 63;
+            uint64_t free = bits.span(base, line);
+            uint64_t before = bits.span(base - 1, line - 1), after = bits.span(base + 1, line - 1);
+            uint64_t side = bits.span(base, line - 1);
+            uint64_t stops = side & ~(direction > 0 ? before : after);
+            before = bits.span(base - 1, line + 1);
+            after = bits.span(base + 1, line + 1);
+            side = bits.span(base, line + 1);
+            stops |= side & ~(direction > 0 ? before : after);
+            if (goal != NONE && goal >= base && goal < base + 64)
+                stops |= uint64_t(1) << (goal - base);
+
+            // Distance (in cells from p) of the first stop and the first obstacle
+            uint64_t blocked = ~free;
+            int stop = stops == 0 ? 64 : (direction > 0 ? lowestBit(stops) : 63 - highestBit(stops));
+            int wall = blocked == 0 ? 64 : (direction > 0 ? lowestBit(blocked) : 63 - highestBit(blocked));
+            if (stop < wall)
+                return p + stop * direction;
+            if (wall < 64)
+                return NONE;
+        }
+    }
+};
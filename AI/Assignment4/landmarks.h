@@ -0,0 +1,358 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "../common/thread_pool.h"
+#include "a_star.h"
+#include "graph.h"
+
+// ALT heuristic: A*, Landmarks and the Triangle inequality.
+//
+// A handful of landmark nodes L is chosen and the exact distances d(L, v) and
+// d(v, L) to and from every node are precomputed. For any target t the
+// triangle inequality gives two lower bounds on d(v, t):
+//     d(L, t) - d(L, v)    and    d(v, L) - d(t, L)
+// and the heuristic is the largest of them over all landmarks. On road
+// networks this is far tighter than straight-line distance.
+//
+// Distances are stored as floats, node-major (the k values of one node are
+// adjacent), so one heuristic evaluation reads two short contiguous runs.
+// Each bound is lowered by the worst-case float rounding error, which keeps it
+// admissible.
+class Landmarks
+{
+public:
+    enum class Selection
+    {
+        Farthest, // each new landmark is the node farthest from the chosen ones
+        Avoid     // Goldberg and Harrelson: go where the current bounds are worst
+    };
+
+    Landmarks() = default;
+
+    static Landmarks build(const Graph &graph, size_t count, Selection selection = Selection::Avoid,
+                           unsigned seed = 1, size_t threads = std::thread::hardware_concurrency())
+    {
+        Landmarks alt;
+        alt.nodes = graph.nodeCount();
+        if (alt.nodes == 0 || count == 0)
+            return alt;
+        alt.k = count;
+        alt.fromLandmark.assign(alt.nodes * count, INF);
+        alt.toLandmark.assign(alt.nodes * count, INF);
+
+        Graph reverse = graph.reversed();
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<NodeId> pick(0, static_cast<NodeId>(alt.nodes - 1));
+        SearchContext forward, backward;
+
+        // Landmarks are picked one at a time, each pick depends on the distances
+        // of the previous ones
+        for (size_t i = 0; i < count; i++)
+        {
+            NodeId next = selection == Selection::Farthest ? alt.farthestNode(pick(rng))
+                                                           : alt.avoidNode(graph, forward, pick(rng));
+            if (next == NO_NODE)
+                break;
+            alt.landmarkIds.push_back(next);
+            alt.record(graph, forward, next, alt.fromLandmark, i);
+        }
+        alt.k = alt.landmarkIds.size();
+        alt.compact(count);
+
+        // Distances towards the landmarks are independent: one search each on the reversed graph
+        ThreadPool pool(std::min(threads, alt.k));
+        std::vector<SearchContext> contexts(pool.size());
+        pool.parallelFor(alt.k, [&](size_t worker, size_t i)
+                         { alt.record(reverse, contexts[worker], alt.landmarkIds[i], alt.toLandmark, i); });
+        return alt;
+    }
+
+    size_t count() const
+    {
+        return k;
+    }
+
+    const std::vector<NodeId> &landmarks() const
+    {
+        return landmarkIds;
+    }
+
+    // Lower bound on d(v, goal)
+    struct Towards
+    {
+        const Landmarks *alt;
+        NodeId goal;
+
+        double operator()(NodeId v) const
+        {
+            return alt->bound(v, goal);
+        }
+    };
+
+    Towards towards(NodeId goal) const
+    {
+        return {this, goal};
+    }
+
+    // Lower bound on d(source, v)
+    struct From
+    {
+        const Landmarks *alt;
+        NodeId source;
+
+        double operator()(NodeId v) const
+        {
+            return alt->bound(source, v);
+        }
+    };
+
+    From from(NodeId source) const
+    {
+        return {this, source};
+    }
+
+    double bound(NodeId from, NodeId to) const
+    {
+        const float *fromV = &fromLandmark[from * k];
+        const float *fromT = &fromLandmark[to * k];
+        const float *toV = &toLandmark[from * k];
+        const float *toT = &toLandmark[to * k];
+        double best = 0;
+        for (size_t i = 0; i < k; i++)
+        {
+            // An infinite term means a landmark cannot reach, or be reached from,
+            // one of the nodes; such terms say nothing safe and are skipped
+            if (fromT[i] != INF && fromV[i] != INF)
+                best = std::max(best, lowered(fromT[i], fromV[i]));
+            if (toV[i] != INF && toT[i] != INF)
+                best = std::max(best, lowered(toV[i], toT[i]));
+        }
+        return best;
+    }
+
+    // File layout: "ALT1", node count (uint64), landmark count (uint32),
+    // landmark ids (uint32 each), then the from- and to-landmark float tables.
+    // Numbers are stored in the byte order of the machine that wrote them.
+    void save(const std::string &path) const
+    {
+        std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(path.c_str(), "wb"), std::fclose);
+        if (!file)
+            throw std::runtime_error("cannot write " + path);
+        uint64_t n = nodes;
+        uint32_t landmarkCount = static_cast<uint32_t>(k);
+        bool ok = std::fwrite(MAGIC, 1, 4, file.get()) == 4 &&
+                  std::fwrite(&n, sizeof n, 1, file.get()) == 1 &&
+                  std::fwrite(&landmarkCount, sizeof landmarkCount, 1, file.get()) == 1 &&
+                  std::fwrite(landmarkIds.data(), sizeof(NodeId), k, file.get()) == k &&
+                  std::fwrite(fromLandmark.data(), sizeof(float), fromLandmark.size(), file.get()) == fromLandmark.size() &&
+                  std::fwrite(toLandmark.data(), sizeof(float), toLandmark.size(), file.get()) == toLandmark.size();
+        if (!ok)
+            throw std::runtime_error("error writing " + path);
+    }
+
+    // Loads tables written by save() for a graph with `nodeCount` nodes;
+    // throws if the file does not match that graph or is damaged
+    static Landmarks load(const std::string &path, size_t nodeCount)
+    {
+        std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(path.c_str(), "rb"), std::fclose);
+        if (!file)
+            throw std::runtime_error("cannot open " + path);
+        char magic[4];
+        uint64_t n;
+        uint32_t landmarkCount;
+        if (std::fread(magic, 1, 4, file.get()) != 4 || std::memcmp(magic, MAGIC, 4) != 0 ||
+            std::fread(&n, sizeof n, 1, file.get()) != 1 || std::fread(&landmarkCount, sizeof landmarkCount, 1, file.get()) != 1)
+            throw std::runtime_error(path + " is not a landmark file");
+        if (n != nodeCount)
+            throw std::runtime_error(path + " was built for a graph with " + std::to_string(n) + " nodes");
+        // build() never picks more landmarks than there are nodes, and never none
+        if (landmarkCount == 0 || landmarkCount > nodeCount)
+            throw std::runtime_error(path + " holds an invalid landmark count of " + std::to_string(landmarkCount));
+        // Sizes the tables are allocated from must match the file before anything is allocated
+        std::error_code error;
+        uint64_t length = std::filesystem::file_size(path, error);
+        uint64_t expected = 4 + sizeof n + sizeof landmarkCount + uint64_t(landmarkCount) * sizeof(NodeId) +
+                            2 * uint64_t(landmarkCount) * n * sizeof(float);
+        if (error || length != expected)
+            throw std::runtime_error(path + " is truncated or corrupt: " + std::to_string(length) + " bytes, expected " +
+                                     std::to_string(expected));
+
+        Landmarks alt;
+        alt.nodes = nodeCount;
+        alt.k = landmarkCount;
+        alt.landmarkIds.resize(alt.k);
+        alt.fromLandmark.resize(alt.nodes * alt.k);
+        alt.toLandmark.resize(alt.nodes * alt.k);
+        bool ok = std::fread(alt.landmarkIds.data(), sizeof(NodeId), alt.k, file.get()) == alt.k &&
+                  std::fread(alt.fromLandmark.data(), sizeof(float), alt.fromLandmark.size(), file.get()) == alt.fromLandmark.size() &&
+                  std::fread(alt.toLandmark.data(), sizeof(float), alt.toLandmark.size(), file.get()) == alt.toLandmark.size();
+        if (!ok)
+            throw std::runtime_error(path + " is truncated");
+        for (NodeId id : alt.landmarkIds)
+        {
+            if (id >= nodeCount)
+                throw std::runtime_error(path + " names landmark " + std::to_string(id) + ", which is not a node");
+        }
+        return alt;
+    }
+
+private:
+    static constexpr float INF = std::numeric_limits<float>::infinity();
+    static constexpr char MAGIC[5] = "ALT1";
+
+    size_t nodes = 0;
+    size_t k = 0;
+    std::vector<NodeId> landmarkIds;
+    std::vector<float> fromLandmark; // [v * k + i] = d(landmark i, v)
+    std::vector<float> toLandmark;   // [v * k + i] = d(v, landmark i)
+
+    // a - b, minus the largest error float rounding can have put into it
+    static double lowered(float a, float b)
+    {
+        double diff = static_cast<double>(a) - b;
+        return diff - (static_cast<double>(a) + b) * std::numeric_limits<float>::epsilon();
+    }
+
+    // One-to-all search from `source`; the distances go to column `column` of `table`
+    void record(const Graph &graph, SearchContext &context, NodeId source, std::vector<float> &table, size_t column) const
+    {
+        context.aStar(graph, source, NO_NODE, ZeroHeuristic{});
+        for (NodeId v = 0; v < nodes; v++)
+        {
+            if (context.reached(v))
+                table[v * k + column] = static_cast<float>(context.distance(v));
+        }
+    }
+
+    // Drops the unused columns when fewer landmarks than requested could be found
+    void compact(size_t requested)
+    {
+        if (k == requested)
+            return;
+        std::vector<float> packed(nodes * k);
+        for (size_t v = 0; v < nodes; v++)
+            std::copy_n(&fromLandmark[v * requested], k, &packed[v * k]);
+        fromLandmark.swap(packed);
+        toLandmark.assign(nodes * k, INF);
+    }
+
+    // Node with the largest distance from its closest landmark so far
+    // (from `start` for the first landmark)
+    NodeId farthestNode(NodeId start) const
+    {
+        size_t chosen = landmarkIds.size();
+        if (chosen == 0)
+            return start;
+        NodeId best = NO_NODE;
+        float bestDistance = -1;
+        for (NodeId v = 0; v < nodes; v++)
+        {
+            float closest = INF;
+            for (size_t i = 0; i < chosen; i++)
+                closest = std::min(closest, fromLandmark[v * k + i]);
+            if (closest != INF && closest > bestDistance)
+            {
+                best = v;
+                bestDistance = closest;
+            }
+        }
+        return bestDistance > 0 ? best : NO_NODE;
+    }
+
+    // Avoid selection: grow a shortest-path tree from a random root and weigh
+    // every node by how much the current landmarks underestimate its distance
+    // from the root. Descend from the root into the heaviest subtree that holds
+    // no landmark yet; the leaf reached becomes the next landmark.
+    NodeId avoidNode(const Graph &graph, SearchContext &context, NodeId root) const
+    {
+        size_t chosen = landmarkIds.size();
+        if (chosen == 0)
+            return farthestFrom(graph, context, root);
+
+        context.aStar(graph, root, NO_NODE, ZeroHeuristic{});
+        std::vector<NodeId> order;
+        for (NodeId v = 0; v < nodes; v++)
+        {
+            if (context.reached(v))
+                order.push_back(v);
+        }
+        std::sort(order.begin(), order.end(), [&](NodeId a, NodeId b)
+                  { return context.distance(a) > context.distance(b); });
+
+        // Subtree weights, children before parents; a landmark blocks its subtree
+        std::vector<double> size(nodes, 0);
+        std::vector<char> blocked(nodes, 0);
+        for (NodeId l : landmarkIds)
+            blocked[l] = 1;
+        for (NodeId v : order)
+        {
+            if (blocked[v])
+                size[v] = 0;
+            else
+                size[v] += std::max(0.0, context.distance(v) - prefixBound(root, v, chosen));
+            NodeId parent = context.parent(v);
+            if (parent != NO_NODE)
+            {
+                if (blocked[v])
+                    blocked[parent] = 1;
+                else
+                    size[parent] += size[v];
+            }
+        }
+
+        // Heaviest child of every node on the way down
+        std::vector<NodeId> heaviest(nodes, NO_NODE);
+        for (NodeId v : order)
+        {
+            NodeId parent = context.parent(v);
+            if (parent != NO_NODE && !blocked[v] && (heaviest[parent] == NO_NODE || size[v] > size[heaviest[parent]]))
+                heaviest[parent] = v;
+        }
+        if (blocked[root] && heaviest[root] == NO_NODE)
+            return farthestNode(root);
+        NodeId v = root;
+        while (heaviest[v] != NO_NODE)
+            v = heaviest[v];
+        return v;
+    }
+
+    // The node farthest from `root`, used as the first landmark
+    NodeId farthestFrom(const Graph &graph, SearchContext &context, NodeId root) const
+    {
+        context.aStar(graph, root, NO_NODE, ZeroHeuristic{});
+        NodeId best = root;
+        for (NodeId v = 0; v < nodes; v++)
+        {
+            if (context.reached(v) && context.distance(v) > context.distance(best))
+                best = v;
+        }
+        return best;
+    }
+
+    // ALT bound from the first `chosen` landmarks, using only the forward tables
+    // (the backward ones are filled in after selection)
+    double prefixBound(NodeId from, NodeId to, size_t chosen) const
+    {
+        double best = 0;
+        for (size_t i = 0; i < chosen; i++)
+        {
+            float a = fromLandmark[to * k + i], b = fromLandmark[from * k + i];
+            if (a != INF && b != INF)
+                best = std::max(best, lowered(a, b));
+        }
+        return best;
+    }
+};
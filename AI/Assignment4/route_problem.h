@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+#include "graph.h"
+
+// Shortest route between two nodes of a Graph as a problem for Search in
+// ../common/search.h. States are node ids and successors follow the outgoing
+// arcs; `Heuristic` is any of the heuristics in a_star.h, e.g.
+// CoordinateHeuristic::Towards or ZeroHeuristic.
+//
+// SearchContext in a_star.h remains the faster choice for graphs, since
+// it indexes its labels by node id directly instead of hashing; this is the
+// same problem for the generic engines (IDA*, iterative deepening, ...).
+template <class Heuristic>
+struct RouteProblem
+{
+    using State = NodeId;
+    using Cost = double;
+
+    const Graph *graph;
+    NodeId goal;
+    Heuristic estimate;
+
+    bool isGoal(NodeId v) const
+    {
+        return v == goal;
+    }
+
+    template <class Visit>
+    void successors(NodeId v, Visit &&visit) const
+    {
+        for (uint32_t a = graph->arcsBegin(v); a < graph->arcsEnd(v); a++)
+            visit(graph->arcHead(a), graph->arcWeight(a));
+    }
+
+    uint64_t hash(NodeId v) const
+    {
+        return v;
+    }
+
+    double heuristic(NodeId v) const
+    {
+        return estimate(v);
+    }
+};
+
+template <class Heuristic>
+RouteProblem<Heuristic> makeRouteProblem(const Graph &graph, NodeId goal, Heuristic estimate)
+{
+    return {&graph, goal, estimate};
+}
@@ -3,26 +3,9 @@
 #include <string>
 #include <unordered_set>
 #include <sstream>
+#include "forward_chaining.h"
 using namespace std;
 
-// Structure for a rule with multiple conditions
-struct Rule
-{
-    vector<string> conditions;
-    string conclusion;
-};
-
-// Helper function to check if all conditions are satisfied
-bool allConditionsMet(const vector<string> &conditions, const unordered_set<string> &facts)
-{
-    for (const auto &cond : conditions)
-    {
-        if (facts.find(cond) == facts.end())
-            return false;
-    }
-    return true;
-}
-
 int main()
 {
     // Step 1: Define rules
@@ -39,23 +22,8 @@ int main()
         cout << "- " << f << endl;
 
     // Step 3: Forward chaining
-    bool newFactAdded = true;
-    while (newFactAdded)
-    {
-        newFactAdded = false;
-
-        for (auto &rule : rules)
-        {
-            if (allConditionsMet(rule.conditions, facts) &&
-                facts.find(rule.conclusion) == facts.end())
-            {
-
-                facts.insert(rule.conclusion);
-                cout << "Derived new fact: " << rule.conclusion << endl;
-                newFactAdded = true;
-            }
-        }
-    }
+    forwardChain(rules, facts, [](const string &fact)
+                 { cout << "Derived new fact: " << fact << endl; });
 
     // Step 4: Final results
     cout << "\nFinal set of facts:\n";
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../common/instrumentation.h"
+
+// Structure for a rule with multiple conditions
+struct Rule
+{
+    std::vector<std::string> conditions;
+    std::string conclusion;
+};
+
+// Helper function to check if all conditions are satisfied
+inline bool allConditionsMet(const std::vector<std::string> &conditions, const std::unordered_set<std::string> &facts)
+{
+    for (const auto &cond : conditions)
+    {
+        if (facts.find(cond) == facts.end())
+            return false;
+    }
+    return true;
+}
+
+// Fires rules until no new fact can be derived; calls onDerived(fact) for
+// every new fact and returns how many there were
+template <class OnDerived>
+size_t forwardChain(const std::vector<Rule> &rules, std::unordered_set<std::string> &facts, OnDerived onDerived)
+{
+    AI_PHASE("forward_chaining.run");
+    size_t derived = 0;
+    bool newFactAdded = true;
+    while (newFactAdded)
+    {
+        newFactAdded = false;
+
+        for (auto &rule : rules)
+        {
+            if (allConditionsMet(rule.conditions, facts) &&
+                facts.find(rule.conclusion) == facts.end())
+            {
+                facts.insert(rule.conclusion);
+                onDerived(rule.conclusion);
+                derived++;
+                AI_COUNT(RuleFirings);
+                newFactAdded = true;
+            }
+        }
+    }
+    return derived;
+}
+
+// --- Benchmark generators ---
+
+// `layers` layers of `width` symbols each. Every symbol above the first layer
+// is the conclusion of one rule whose 1 .. maxConditions conditions come from
+// the layer below; the first layer are the facts. The rules are listed top
+// layer first, the worst order for the loop above, which then needs one pass
+// per layer.
+inline std::vector<Rule> makeLayeredRules(size_t layers, size_t width, size_t maxConditions, unsigned seed,
+                                          std::unordered_set<std::string> &facts)
+{
+    auto symbol = [](size_t layer, size_t i)
+    { return "l" + std::to_string(layer) + "_" + std::to_string(i); };
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, width - 1);
+    std::uniform_int_distribution<size_t> count(1, maxConditions);
+    std::vector<Rule> rules;
+    rules.reserve(layers > 0 ? (layers - 1) * width : 0);
+    for (size_t layer = layers; layer-- > 1;)
+    {
+        for (size_t i = 0; i < width; i++)
+        {
+            Rule rule;
+            rule.conditions.resize(count(rng));
+            for (auto &cond : rule.conditions)
+                cond = symbol(layer - 1, pick(rng));
+            rule.conclusion = symbol(layer, i);
+            rules.push_back(std::move(rule));
+        }
+    }
+    for (size_t i = 0; layers > 0 && i < width; i++)
+        facts.insert(symbol(0, i));
+    return rules;
+}
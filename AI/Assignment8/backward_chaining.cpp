@@ -1,76 +1,276 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+#include <utility>
+#include "backward_chaining.h"
+#include "query_service.h"
 using namespace std;
 
-// Structure to store rules
-struct Rule
+double secondsSince(chrono::steady_clock::time_point start)
 {
-    vector<string> conditions;
-    string conclusion;
-};
-
-// Recursive backward chaining function
-bool backwardChain(const string &goal,
-                   const vector<Rule> &rules,
-                   const unordered_set<string> &facts,
-                   unordered_set<string> &visited)
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Usage: backward_chaining --bench chain <depth>
+//        backward_chaining --bench wide <rules> [queries]
+int runBenchmark(int argc, char *argv[])
 {
+    string shape = argv[2];
+    size_t size = strtoull(argv[3], nullptr, 10);
+    BackwardChainer kb;
 
-    // If goal already known
-    if (facts.find(goal) != facts.end())
-        return true;
+    auto start = chrono::steady_clock::now();
+    vector<SymbolId> goals;
+    if (shape == "chain")
+    {
+        goals.push_back(makeChainRuleBase(kb, size));
+    }
+    else if (shape == "wide")
+    {
+        makeWideRuleBase(kb, size, 42);
+        size_t queries = argc > 4 ? strtoull(argv[4], nullptr, 10) : 1000;
+        for (size_t i = 0; i < queries; i++)
+            goals.push_back(static_cast<SymbolId>((i * 2654435761u) % kb.symbolCount()));
+    }
+    else
+    {
+        cout << "Unknown benchmark shape: " << shape << "\n";
+        return 1;
+    }
+    cout << "Built " << kb.ruleCount() << " rules over " << kb.symbolCount() << " symbols in "
+         << secondsSince(start) << " s\n";
 
-    // Prevent infinite recursion
-    if (visited.find(goal) != visited.end())
-        return false;
-    visited.insert(goal);
+    // The first pass fills the answer table, the second one only reads it
+    for (const char *pass : {"cold", "warm"})
+    {
+        start = chrono::steady_clock::now();
+        size_t proven = 0;
+        for (auto goal : goals)
+            proven += kb.backwardChain(goal);
+        cout << pass << ": " << goals.size() << " queries, " << proven << " proven, "
+             << secondsSince(start) << " s\n";
+    }
+    cout << "Answers kept in the table: " << kb.tabledGoals() << endl;
+    return 0;
+}
 
-    // Search for rules that can conclude the goal
-    for (const auto &rule : rules)
+double percentile(vector<double> values, double p)
+{
+    if (values.empty())
+        return 0;
+    size_t k = min(values.size() - 1, static_cast<size_t>(p * values.size()));
+    nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+// Usage: backward_chaining --bench-service <rules> [max threads] [queries]
+// Runs the same query stream against a fresh answer cache with 1, 2, 4, ...
+// worker threads and reports throughput and per-query latency.
+int runServiceBenchmark(int argc, char *argv[])
+{
+    size_t ruleCount = strtoull(argv[2], nullptr, 10);
+    size_t maxThreads = argc > 3 ? strtoull(argv[3], nullptr, 10) : thread::hardware_concurrency();
+    size_t queries = argc > 4 ? strtoull(argv[4], nullptr, 10) : 100000;
+    const size_t batchSize = 1000;
+
+    BackwardChainer kb;
+    makeWideRuleBase(kb, ruleCount, 42);
+    auto snapshot = kb.snapshot();
+    cout << "Snapshot v" << snapshot->version() << ": " << snapshot->ruleCount() << " rules over "
+         << snapshot->symbolCount() << " symbols\n";
+
+    vector<SymbolId> goals(queries);
+    mt19937 rng(7);
+    for (auto &goal : goals)
+        goal = static_cast<SymbolId>(rng() % snapshot->symbolCount());
+
+    for (size_t threads = 1; threads <= max<size_t>(maxThreads, 1); threads *= 2)
+    {
+        QueryService service(threads);
+        service.publish(snapshot);
+
+        vector<double> latencies, batchLatencies;
+        auto start = chrono::steady_clock::now();
+        for (size_t begin = 0; begin < goals.size(); begin += batchSize)
+        {
+            vector<SymbolId> batch(goals.begin() + begin, goals.begin() + min(goals.size(), begin + batchSize));
+            service.proveBatch(batch, &batchLatencies);
+            latencies.insert(latencies.end(), batchLatencies.begin(), batchLatencies.end());
+        }
+        double seconds = secondsSince(start);
+        cout << threads << " threads: " << static_cast<size_t>(goals.size() / seconds) << " queries/s, p50 "
+             << percentile(latencies, 0.50) << " us, p99 " << percentile(latencies, 0.99) << " us\n";
+    }
+    return 0;
+}
+
+// Least fixpoint of the rules by plain forward chaining: the answers every
+// query must agree with
+vector<char> provableByClosure(const vector<pair<vector<SymbolId>, SymbolId>> &rules, const vector<SymbolId> &facts,
+                               size_t symbols)
+{
+    vector<char> proven(symbols, 0);
+    for (SymbolId fact : facts)
+        proven[fact] = 1;
+    for (bool changed = true; changed;)
     {
-        if (rule.conclusion == goal)
+        changed = false;
+        for (const auto &rule : rules)
         {
-            bool allTrue = true;
-            for (const auto &cond : rule.conditions)
+            bool holds = all_of(rule.first.begin(), rule.first.end(), [&](SymbolId c)
+                                { return proven[c] != 0; });
+            if (holds && !proven[rule.second])
+                proven[rule.second] = changed = true;
+        }
+    }
+    return proven;
+}
+
+// Usage: backward_chaining --self-test
+// Checks the answers on rule bases with cycles against forward chaining,
+// asking the goals in every order so that each one is first reached from
+// inside an open cycle at some point. Returns 1 on any wrong answer.
+int runSelfTest()
+{
+    size_t failures = 0;
+
+    // Y needs B and C; B is only provable through the cycle Z <- Y <- B <- Z,
+    // which is entered from Z <- F. Y must not be tabled as unprovable while
+    // B is still open.
+    vector<string> goals = {"Y", "Z", "B", "C", "F"};
+    sort(goals.begin(), goals.end());
+    do
+    {
+        BackwardChainer kb;
+        kb.addRule({{"Y"}, "Z"});
+        kb.addRule({{"B", "C"}, "Y"});
+        kb.addRule({{"Z"}, "B"});
+        kb.addRule({{"F"}, "Z"});
+        kb.addRule({{"F"}, "C"});
+        kb.addFact("F");
+        for (const string &goal : goals)
+        {
+            if (!kb.backwardChain(goal))
+            {
+                cout << "FAIL: " << goal << " not proven when asked in order";
+                for (const string &g : goals)
+                    cout << " " << g;
+                cout << "\n";
+                failures++;
+            }
+        }
+    } while (next_permutation(goals.begin(), goals.end()));
+
+    // Small random rule bases are dense in cycles; part of the rules is
+    // added only after the first queries, so answers carried over between
+    // snapshot versions are checked too
+    mt19937 rng(26);
+    for (int round = 0; round < 5000; round++)
+    {
+        size_t symbols = 2 + rng() % 8, ruleCount = 1 + rng() % 14;
+        vector<pair<vector<SymbolId>, SymbolId>> rules(ruleCount);
+        for (auto &rule : rules)
+        {
+            rule.first.resize(1 + rng() % 3);
+            for (auto &c : rule.first)
+                c = static_cast<SymbolId>(rng() % symbols);
+            rule.second = static_cast<SymbolId>(rng() % symbols);
+        }
+        vector<SymbolId> facts(1 + rng() % 2);
+        for (auto &fact : facts)
+            fact = static_cast<SymbolId>(rng() % symbols);
+
+        BackwardChainer kb;
+        for (size_t s = 0; s < symbols; s++)
+            kb.intern("s" + to_string(s));
+        for (SymbolId fact : facts)
+            kb.addFact(fact);
+        size_t split = rng() % (ruleCount + 1);
+        for (size_t step = 0; step < 2; step++)
+        {
+            size_t end = step == 0 ? split : ruleCount;
+            for (size_t r = step == 0 ? 0 : split; r < end; r++)
+                kb.addRule(rules[r].first, rules[r].second);
+            vector<pair<vector<SymbolId>, SymbolId>> added(rules.begin(), rules.begin() + end);
+            vector<char> expected = provableByClosure(added, facts, symbols);
+            for (size_t q = 0; q < 2 * symbols; q++)
             {
-                if (!backwardChain(cond, rules, facts, visited))
+                SymbolId goal = static_cast<SymbolId>(rng() % symbols);
+                if (kb.backwardChain(goal) != (expected[goal] != 0))
                 {
-                    allTrue = false;
-                    break;
+                    cout << "FAIL: random rule base " << round << ", goal s" << goal << "\n";
+                    failures++;
                 }
             }
-            if (allTrue)
-                return true;
         }
     }
-    return false;
+
+    // Proven answers must not carry over between snapshots of different rule
+    // bases, even when their symbols have the same ids
+    BackwardChainer proving, other;
+    proving.addRule({{"F"}, "X"});
+    proving.addFact("F");
+    other.addRule({{"F"}, "X"});
+    other.addFact("Y");
+    QueryService service(2);
+    for (const auto &snapshot : {proving.snapshot(), other.snapshot(), proving.snapshot()})
+    {
+        service.publish(snapshot);
+        bool expected = snapshot == proving.snapshot();
+        if (service.proveBatch(vector<string>{"X"})[0] != expected)
+        {
+            cout << "FAIL: answer carried over from a snapshot of another rule base\n";
+            failures++;
+        }
+    }
+
+    cout << (failures == 0 ? "All answers agree with forward chaining\n" : "Some answers are wrong\n");
+    return failures == 0 ? 0 : 1;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
+    if (argc == 2 && strcmp(argv[1], "--self-test") == 0)
+        return runSelfTest();
+    if (argc >= 4 && strcmp(argv[1], "--bench") == 0)
+        return runBenchmark(argc, argv);
+    if (argc >= 3 && strcmp(argv[1], "--bench-service") == 0)
+        return runServiceBenchmark(argc, argv);
+
+    BackwardChainer kb;
+
     // Define rules
     vector<Rule> rules = {
         {{"it is raining"}, "ground is wet"},
         {{"ground is wet"}, "road is slippery"},
-        {{"road is slippery"}, "drive carefully"}};
+        {{"road is slippery"}, "drive carefully"},
+        // A cycle: each of these can only be proven through the other
+        {{"road is slippery"}, "traffic is slow"},
+        {{"traffic is slow"}, "road is slippery"}};
+    for (const auto &rule : rules)
+        kb.addRule(rule);
 
     // Known facts
-    unordered_set<string> facts = {"it is raining"};
-
-    // Goal
-    string goal = "drive carefully";
+    kb.addFact("it is raining");
 
-    unordered_set<string> visited;
+    // Goals
+    vector<string> goals = {"drive carefully", "traffic is slow", "drive carefully", "roads are closed"};
 
-    cout << "Goal: " << goal << endl;
+    for (const string &goal : goals)
+    {
+        cout << "Goal: " << goal << endl;
 
-    if (backwardChain(goal, rules, facts, visited))
-        cout << "Goal can be proven from the known facts.\n";
-    else
-        cout << "Goal cannot be proven from the known facts.\n";
+        if (kb.backwardChain(goal))
+            cout << "Goal can be proven from the known facts.\n";
+        else
+            cout << "Goal cannot be proven from the known facts.\n";
+    }
+    cout << "Answers kept in the table: " << kb.tabledGoals() << endl;
 
     return 0;
 }
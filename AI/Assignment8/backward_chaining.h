@@ -0,0 +1,725 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../common/instrumentation.h"
+
+// Structure to store rules
+struct Rule
+{
+    std::vector<std::string> conditions;
+    std::string conclusion;
+};
+
+using SymbolId = int32_t;
+constexpr SymbolId NO_SYMBOL = -1;
+
+// Plain storage for rules and facts over interned symbols.
+// Conditions of rule r are ruleConditions[conditionStart[r] .. conditionStart[r + 1]).
+struct RuleBase
+{
+    std::unordered_map<std::string, SymbolId> ids;
+    std::vector<std::string> names;
+    std::vector<SymbolId> ruleConclusion;
+    std::vector<uint32_t> conditionStart{0};
+    std::vector<SymbolId> ruleConditions;
+    std::vector<SymbolId> facts;
+};
+
+// Immutable, shareable view of a rule base.
+// The rules are indexed by conclusion, so finding the rules for a goal costs
+// O(matching rules) with no string comparisons. Nothing changes after
+// construction, so any number of threads can query one snapshot.
+//
+// Snapshots frozen by one BackwardChainer share a lineage, and each holds every
+// rule and fact of the older ones. Lineage 0 is a snapshot of unknown origin.
+class RuleSnapshot
+{
+public:
+    RuleSnapshot(RuleBase rules, uint64_t version, uint64_t lineage = 0)
+        : base(std::move(rules)), snapshotVersion(version), snapshotLineage(lineage)
+    {
+        // Counting sort of rules by conclusion: O(symbols + rules)
+        size_t symbols = base.names.size();
+        indexStart.assign(symbols + 1, 0);
+        for (SymbolId c : base.ruleConclusion)
+            indexStart[c + 1]++;
+        for (size_t s = 0; s < symbols; s++)
+            indexStart[s + 1] += indexStart[s];
+        indexedRules.resize(base.ruleConclusion.size());
+        std::vector<uint32_t> fill(indexStart.begin(), indexStart.end() - 1);
+        for (uint32_t r = 0; r < base.ruleConclusion.size(); r++)
+            indexedRules[fill[base.ruleConclusion[r]]++] = r;
+    }
+
+    uint64_t version() const
+    {
+        return snapshotVersion;
+    }
+
+    uint64_t lineage() const
+    {
+        return snapshotLineage;
+    }
+
+    // Whether this snapshot holds every rule and fact of the given version
+    bool extends(uint64_t lineage, uint64_t version) const
+    {
+        return snapshotLineage != 0 && lineage == snapshotLineage && version <= snapshotVersion;
+    }
+
+    const RuleBase &data() const
+    {
+        return base;
+    }
+
+    size_t symbolCount() const
+    {
+        return base.names.size();
+    }
+
+    size_t ruleCount() const
+    {
+        return base.ruleConclusion.size();
+    }
+
+    SymbolId find(const std::string &name) const
+    {
+        auto it = base.ids.find(name);
+        return it == base.ids.end() ? NO_SYMBOL : it->second;
+    }
+
+    const std::string &name(SymbolId id) const
+    {
+        return base.names[id];
+    }
+
+    // Positions in indexedRules of the rules concluding `goal`
+    uint32_t rulesBegin(SymbolId goal) const
+    {
+        return indexStart[goal];
+    }
+
+    uint32_t rulesEnd(SymbolId goal) const
+    {
+        return indexStart[goal + 1];
+    }
+
+    uint32_t indexedRule(uint32_t position) const
+    {
+        return indexedRules[position];
+    }
+
+    uint32_t conditionsBegin(uint32_t rule) const
+    {
+        return base.conditionStart[rule];
+    }
+
+    uint32_t conditionsEnd(uint32_t rule) const
+    {
+        return base.conditionStart[rule + 1];
+    }
+
+    SymbolId condition(uint32_t position) const
+    {
+        return base.ruleConditions[position];
+    }
+
+    SymbolId conclusion(uint32_t rule) const
+    {
+        return base.ruleConclusion[rule];
+    }
+
+private:
+    RuleBase base;
+    uint64_t snapshotVersion;
+    uint64_t snapshotLineage;
+    std::vector<uint32_t> indexStart;
+    std::vector<uint32_t> indexedRules;
+};
+
+// Answer table for one snapshot version, safe to share between threads.
+// Only final answers are ever written (a proof, or a disproof after its SCC
+// completed), and they are the same whichever thread derives them, so entries
+// are plain relaxed atomics that move once from UNKNOWN to their final value.
+class AnswerCache
+{
+public:
+    enum Status : uint8_t
+    {
+        UNKNOWN, // not evaluated yet, or still being evaluated
+        PROVEN,
+        DISPROVEN
+    };
+
+    // New rules and facts can only make more goals provable, so the proven
+    // answers of the previous version carry over and the negative ones are
+    // dropped. Nothing carries over unless `rules` extends that version.
+    explicit AnswerCache(const RuleSnapshot &rules, const AnswerCache *previous = nullptr)
+        : cacheVersion(rules.version()), cacheLineage(rules.lineage()), count(rules.symbolCount()),
+          status(new std::atomic<uint8_t>[count])
+    {
+        if (previous != nullptr && !rules.extends(previous->cacheLineage, previous->cacheVersion))
+            previous = nullptr;
+        for (size_t s = 0; s < count; s++)
+        {
+            bool proven = previous != nullptr && s < previous->count && previous->get(static_cast<SymbolId>(s)) == PROVEN;
+            status[s].store(proven ? PROVEN : UNKNOWN, std::memory_order_relaxed);
+        }
+        for (SymbolId fact : rules.data().facts)
+            status[fact].store(PROVEN, std::memory_order_relaxed);
+    }
+
+    uint64_t version() const
+    {
+        return cacheVersion;
+    }
+
+    Status get(SymbolId goal) const
+    {
+        return static_cast<Status>(status[goal].load(std::memory_order_relaxed));
+    }
+
+    void set(SymbolId goal, Status answer)
+    {
+        uint8_t expected = UNKNOWN;
+        status[goal].compare_exchange_strong(expected, answer, std::memory_order_relaxed);
+    }
+
+    // Number of goals with a final answer, facts included
+    size_t tabledGoals() const
+    {
+        size_t known = 0;
+        for (size_t s = 0; s < count; s++)
+            known += get(static_cast<SymbolId>(s)) != UNKNOWN;
+        return known;
+    }
+
+private:
+    uint64_t cacheVersion;
+    uint64_t cacheLineage;
+    size_t count;
+    std::unique_ptr<std::atomic<uint8_t>[]> status;
+};
+
+// Tabled backward chaining over one snapshot.
+//
+// Goals that depend on each other (cycles in the rules) are evaluated together:
+// a Tarjan-style depth-first search finds each strongly connected component (SCC)
+// of subgoals, and when the component is complete its members are resolved
+// together by a least-fixpoint pass instead of failing at the first revisit.
+// The AND/OR search runs on an explicit stack, so rule chains of any depth are
+// handled without growing the C++ call stack.
+//
+// A ProofSearch is the scratch arena of one query at a time: its buffers are
+// reused across queries and reset in O(touched goals). Use one per thread.
+//
+// For the counters of instrumentation.h a goal pushed on the stack is
+// expanded, every condition it looks at is generated, a condition that is
+// already open on the stack is a pruned duplicate, abandoning a rule is a
+// backtrack and proving a goal by a rule is a rule firing. Queries answered
+// from the table count nothing. Single queries are too short to time as
+// phases; QueryService times its batches instead.
+class ProofSearch
+{
+public:
+    bool prove(const RuleSnapshot &rules, AnswerCache &answers, SymbolId goal)
+    {
+        if (answers.get(goal) == AnswerCache::UNKNOWN)
+        {
+            if (order.size() < rules.symbolCount())
+            {
+                order.resize(rules.symbolCount(), UNVISITED);
+                lowLink.resize(rules.symbolCount(), UNVISITED);
+            }
+            solve(rules, answers, goal);
+            expandedGoals.flush();
+            generatedGoals.flush();
+            prunedGoals.flush();
+            backtracks.flush();
+            firings.flush();
+            for (SymbolId s : touched)
+                order[s] = lowLink[s] = UNVISITED;
+            touched.clear();
+        }
+        return answers.get(goal) == AnswerCache::PROVEN;
+    }
+
+private:
+    static constexpr int32_t UNVISITED = -1;
+
+    // One goal on the AND/OR search stack
+    struct Frame
+    {
+        SymbolId goal;
+        uint32_t rule;      // position in the conclusion index of the rule being tried
+        uint32_t condition; // position of the next condition of that rule
+        bool blocked;       // current rule waits on a goal of the open SCC
+    };
+
+    std::vector<int32_t> order;
+    std::vector<int32_t> lowLink;
+    std::vector<SymbolId> touched;
+    std::vector<SymbolId> sccStack;
+    std::vector<Frame> frames;
+    int32_t nextOrder = 0;
+
+    // Scratch for completing an SCC
+    std::vector<uint32_t> sccRules;
+    std::vector<uint32_t> sccPending;
+    std::vector<std::pair<SymbolId, uint32_t>> sccWatch;
+    std::vector<SymbolId> sccQueue;
+    std::vector<char> sccProven;
+
+    CounterTally<Counter::NodesExpanded> expandedGoals;
+    CounterTally<Counter::NodesGenerated> generatedGoals;
+    CounterTally<Counter::DuplicatesPruned> prunedGoals;
+    CounterTally<Counter::Backtracks> backtracks;
+    CounterTally<Counter::RuleFirings> firings;
+
+    void push(const RuleSnapshot &rules, SymbolId goal)
+    {
+        expandedGoals.add();
+        order[goal] = lowLink[goal] = nextOrder++;
+        touched.push_back(goal);
+        sccStack.push_back(goal);
+        uint32_t firstRule = rules.rulesBegin(goal);
+        uint32_t firstCondition = firstRule < rules.rulesEnd(goal) ? rules.conditionsBegin(rules.indexedRule(firstRule)) : 0;
+        frames.push_back({goal, firstRule, firstCondition, false});
+    }
+
+    void nextRule(const RuleSnapshot &rules, Frame &f)
+    {
+        backtracks.add();
+        f.rule++;
+        f.blocked = false;
+        if (f.rule < rules.rulesEnd(f.goal))
+            f.condition = rules.conditionsBegin(rules.indexedRule(f.rule));
+    }
+
+    void solve(const RuleSnapshot &rules, AnswerCache &answers, SymbolId root)
+    {
+        nextOrder = 0;
+        push(rules, root);
+        while (!frames.empty())
+        {
+            Frame &f = frames.back();
+            SymbolId goal = f.goal;
+
+            if (answers.get(goal) != AnswerCache::PROVEN && f.rule < rules.rulesEnd(goal))
+            {
+                uint32_t r = rules.indexedRule(f.rule);
+                if (f.condition < rules.conditionsEnd(r))
+                {
+                    SymbolId cond = rules.condition(f.condition);
+                    AnswerCache::Status known = answers.get(cond);
+                    generatedGoals.add();
+                    if (known == AnswerCache::PROVEN)
+                    {
+                        f.condition++;
+                    }
+                    else if (known == AnswerCache::DISPROVEN)
+                    {
+                        nextRule(rules, f);
+                    }
+                    else if (order[cond] == UNVISITED)
+                    {
+                        // Descend; the condition is looked at again once it returns
+                        push(rules, cond);
+                    }
+                    else
+                    {
+                        // Cycle: cond is still open, so this rule is revisited when the
+                        // whole component completes. Keep evaluating the other
+                        // conditions so the completion pass sees final answers for them.
+                        lowLink[goal] = std::min(lowLink[goal], order[cond]);
+                        prunedGoals.add();
+                        f.blocked = true;
+                        f.condition++;
+                    }
+                    continue;
+                }
+                if (f.blocked)
+                {
+                    nextRule(rules, f);
+                    continue;
+                }
+                // All conditions hold; a proof never becomes invalid, so record it right away
+                answers.set(goal, AnswerCache::PROVEN);
+                firings.add();
+            }
+
+            // Every rule for this goal has been tried (or one succeeded)
+            frames.pop_back();
+            if (lowLink[goal] == order[goal])
+                completeComponent(rules, answers, goal);
+            else if (!frames.empty())
+            {
+                SymbolId parent = frames.back().goal;
+                lowLink[parent] = std::min(lowLink[parent], lowLink[goal]);
+            }
+        }
+    }
+
+    // Resolves the SCC rooted at `root`: rules whose conditions are all proven are
+    // fired until nothing changes (conditions outside the SCC are already final).
+    // Whatever is still unproven afterwards cannot be derived.
+    //
+    // The fixpoint is tracked in sccProven rather than read back from the shared
+    // answers, so members proven concurrently by another thread do not hide
+    // derivations from this pass.
+    void completeComponent(const RuleSnapshot &rules, AnswerCache &answers, SymbolId root)
+    {
+        size_t begin = sccStack.size();
+        do
+            begin--;
+        while (sccStack[begin] != root);
+        size_t members = sccStack.size() - begin;
+
+        if (members > 1)
+        {
+            // lowLink is not needed once the component is complete, so it is
+            // reused to map each member to its slot in sccProven
+            sccProven.assign(members, 0);
+            for (size_t i = 0; i < members; i++)
+                lowLink[sccStack[begin + i]] = static_cast<int32_t>(i);
+
+            // Count the unproven conditions of every live rule of an unproven member
+            sccRules.clear();
+            sccPending.clear();
+            sccWatch.clear();
+            sccQueue.clear();
+            for (size_t i = 0; i < members; i++)
+            {
+                SymbolId member = sccStack[begin + i];
+                if (answers.get(member) == AnswerCache::PROVEN)
+                {
+                    sccProven[i] = 1;
+                    sccQueue.push_back(member);
+                    continue;
+                }
+                for (uint32_t k = rules.rulesBegin(member); k < rules.rulesEnd(member) && !sccProven[i]; k++)
+                {
+                    uint32_t r = rules.indexedRule(k);
+                    size_t watchStart = sccWatch.size();
+                    uint32_t slot = static_cast<uint32_t>(sccRules.size());
+                    uint32_t pending = 0;
+                    bool dead = false;
+                    for (uint32_t c = rules.conditionsBegin(r); c < rules.conditionsEnd(r) && !dead; c++)
+                    {
+                        SymbolId cond = rules.condition(c);
+                        AnswerCache::Status known = answers.get(cond);
+                        if (known == AnswerCache::DISPROVEN)
+                            dead = true;
+                        else if (known != AnswerCache::PROVEN)
+                        {
+                            sccWatch.push_back({cond, slot});
+                            pending++;
+                        }
+                    }
+                    if (dead)
+                    {
+                        sccWatch.resize(watchStart);
+                    }
+                    else if (pending == 0)
+                    {
+                        // Its conditions were proven after the rule was last tried
+                        sccProven[i] = 1;
+                        answers.set(member, AnswerCache::PROVEN);
+                        firings.add();
+                        sccQueue.push_back(member);
+                    }
+                    else
+                    {
+                        sccRules.push_back(r);
+                        sccPending.push_back(pending);
+                    }
+                }
+            }
+            std::sort(sccWatch.begin(), sccWatch.end());
+
+            // Propagate proofs through the component
+            while (!sccQueue.empty())
+            {
+                SymbolId proven = sccQueue.back();
+                sccQueue.pop_back();
+                auto it = std::lower_bound(sccWatch.begin(), sccWatch.end(), std::make_pair(proven, uint32_t(0)));
+                for (; it != sccWatch.end() && it->first == proven; ++it)
+                {
+                    if (--sccPending[it->second] != 0)
+                        continue;
+                    SymbolId conclusion = rules.conclusion(sccRules[it->second]);
+                    char &done = sccProven[lowLink[conclusion]];
+                    if (!done)
+                    {
+                        done = 1;
+                        answers.set(conclusion, AnswerCache::PROVEN);
+                        firings.add();
+                        sccQueue.push_back(conclusion);
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < members; i++)
+            {
+                if (!sccProven[i])
+                    answers.set(sccStack[begin + i], AnswerCache::DISPROVEN);
+            }
+        }
+        else if (answers.get(root) != AnswerCache::PROVEN)
+        {
+            // A single goal can only have been blocked on itself
+            answers.set(root, AnswerCache::DISPROVEN);
+        }
+        sccStack.resize(begin);
+    }
+};
+
+// Single-threaded front end: collects rules and facts, and answers queries
+// against a snapshot that is refrozen only after the rules have changed.
+// Answers are kept in a table across queries, so repeated questions are
+// answered by a single lookup.
+class BackwardChainer
+{
+public:
+    // Returns the id of a symbol, creating it if needed
+    SymbolId intern(const std::string &name)
+    {
+        auto it = current().ids.find(name);
+        if (it != current().ids.end())
+            return it->second;
+        RuleBase &rules = editable();
+        SymbolId id = static_cast<SymbolId>(rules.names.size());
+        rules.ids.emplace(name, id);
+        rules.names.push_back(name);
+        return id;
+    }
+
+    // Returns the id of a known symbol or NO_SYMBOL
+    SymbolId find(const std::string &name) const
+    {
+        auto it = current().ids.find(name);
+        return it == current().ids.end() ? NO_SYMBOL : it->second;
+    }
+
+    const std::string &name(SymbolId id) const
+    {
+        return current().names[id];
+    }
+
+    void addRule(const Rule &rule)
+    {
+        std::vector<SymbolId> conditionIds;
+        conditionIds.reserve(rule.conditions.size());
+        for (const auto &cond : rule.conditions)
+            conditionIds.push_back(intern(cond));
+        addRule(conditionIds, intern(rule.conclusion));
+    }
+
+    void addRule(const std::vector<SymbolId> &conditions, SymbolId conclusion)
+    {
+        RuleBase &rules = editable();
+        rules.ruleConclusion.push_back(conclusion);
+        rules.ruleConditions.insert(rules.ruleConditions.end(), conditions.begin(), conditions.end());
+        rules.conditionStart.push_back(static_cast<uint32_t>(rules.ruleConditions.size()));
+    }
+
+    void addFact(const std::string &fact)
+    {
+        addFact(intern(fact));
+    }
+
+    void addFact(SymbolId fact)
+    {
+        editable().facts.push_back(fact);
+    }
+
+    bool backwardChain(const std::string &goal)
+    {
+        SymbolId id = find(goal);
+        // A symbol that appears in no rule and no fact cannot be proven
+        return id != NO_SYMBOL && backwardChain(id);
+    }
+
+    bool backwardChain(SymbolId goal)
+    {
+        snapshot();
+        return search.prove(*frozen, *answers, goal);
+    }
+
+    // Freezes the current rules and facts. The snapshot can be handed to a
+    // concurrent query service; it is rebuilt only after the next change.
+    std::shared_ptr<const RuleSnapshot> snapshot()
+    {
+        if (!frozen || changed)
+        {
+            AI_PHASE("backward_chaining.snapshot");
+            // The new version takes over the storage; it is copied back only
+            // if rules are added again later.
+            frozen = std::make_shared<const RuleSnapshot>(std::move(editable()), nextVersion++, lineage.id);
+            answers = std::make_shared<AnswerCache>(*frozen, answers.get());
+            movedOut = true;
+            changed = false;
+        }
+        return frozen;
+    }
+
+    size_t symbolCount() const
+    {
+        return current().names.size();
+    }
+
+    size_t ruleCount() const
+    {
+        return current().ruleConclusion.size();
+    }
+
+    size_t tabledGoals() const
+    {
+        return answers ? answers->tabledGoals() : 0;
+    }
+
+    // Pre-reserves storage for bulk loading
+    void reserve(size_t symbols, size_t rules, size_t conditions)
+    {
+        RuleBase &base = editable();
+        base.ids.reserve(symbols);
+        base.names.reserve(symbols);
+        base.ruleConclusion.reserve(rules);
+        base.conditionStart.reserve(rules + 1);
+        base.ruleConditions.reserve(conditions);
+    }
+
+private:
+    // Identifies the snapshots of this chainer; a copy starts a lineage of its own
+    struct Lineage
+    {
+        uint64_t id = next();
+
+        Lineage() = default;
+        Lineage(const Lineage &) : id(next()) {}
+
+        Lineage &operator=(const Lineage &)
+        {
+            id = next();
+            return *this;
+        }
+
+        static uint64_t next()
+        {
+            static std::atomic<uint64_t> counter{0};
+            return ++counter;
+        }
+    };
+
+    RuleBase building;
+    Lineage lineage;
+    bool movedOut = false;
+    bool changed = false;
+    uint64_t nextVersion = 1;
+    std::shared_ptr<const RuleSnapshot> frozen;
+    std::shared_ptr<AnswerCache> answers;
+    ProofSearch search;
+
+    const RuleBase &current() const
+    {
+        return movedOut ? frozen->data() : building;
+    }
+
+    RuleBase &editable()
+    {
+        if (movedOut)
+        {
+            building = frozen->data();
+            movedOut = false;
+        }
+        changed = true;
+        return building;
+    }
+};
+
+// --- Benchmark generators ---
+
+// A single chain p0 <- p1 <- ... <- p(depth), with p(depth) a fact.
+// Proving p0 walks the whole chain. Returns the id of p0.
+inline SymbolId makeChainRuleBase(BackwardChainer &kb, size_t depth)
+{
+    kb.reserve(depth + 1, depth, depth);
+    std::vector<SymbolId> cond(1);
+    SymbolId first = kb.intern("p0");
+    SymbolId previous = first;
+    for (size_t i = 1; i <= depth; i++)
+    {
+        SymbolId next = kb.intern("p" + std::to_string(i));
+        cond[0] = next;
+        kb.addRule(cond, previous);
+        previous = next;
+    }
+    kb.addFact(previous);
+    return first;
+}
+
+// A wide random rule base: `rules` rules over rules / 8 symbols, each rule with
+// one to three random conditions, so it contains many cycles and shared
+// subgoals. About one symbol in a hundred is a fact.
+inline void makeWideRuleBase(BackwardChainer &kb, size_t rules, unsigned seed)
+{
+    size_t symbols = std::max<size_t>(rules / 8, 16);
+    kb.reserve(symbols, rules, rules * 2);
+    for (size_t i = 0; i < symbols; i++)
+        kb.intern("s" + std::to_string(i));
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<SymbolId> pick(0, static_cast<SymbolId>(symbols - 1));
+    std::uniform_int_distribution<int> width(1, 3);
+    std::vector<SymbolId> cond;
+    for (size_t r = 0; r < rules; r++)
+    {
+        cond.resize(width(rng));
+        for (auto &c : cond)
+            c = pick(rng);
+        kb.addRule(cond, pick(rng));
+    }
+    for (size_t i = 0; i < symbols / 100 + 1; i++)
+        kb.addFact(pick(rng));
+}
+
+// `layers` layers of `width` symbols, interned layer by layer (symbol i of
+// layer l has id l * width + i). Every symbol above the first layer is the
+// conclusion of one rule whose 1 .. maxConditions conditions come from the
+// layer below; the first layer are the facts, so everything can be proven and
+// a query on the top layer descends through all of them.
+inline void makeLayeredRuleBase(BackwardChainer &kb, size_t layers, size_t width, size_t maxConditions, unsigned seed)
+{
+    kb.reserve(layers * width, layers * width, layers * width * maxConditions);
+    for (size_t layer = 0; layer < layers; layer++)
+    {
+        for (size_t i = 0; i < width; i++)
+            kb.intern("l" + std::to_string(layer) + "_" + std::to_string(i));
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, width - 1);
+    std::uniform_int_distribution<size_t> count(1, maxConditions);
+    std::vector<SymbolId> cond;
+    for (size_t layer = 1; layer < layers; layer++)
+    {
+        for (size_t i = 0; i < width; i++)
+        {
+            cond.resize(count(rng));
+            for (auto &c : cond)
+                c = static_cast<SymbolId>((layer - 1) * width + pick(rng));
+            kb.addRule(cond, static_cast<SymbolId>(layer * width + i));
+        }
+    }
+    for (size_t i = 0; layers > 0 && i < width; i++)
+        kb.addFact(static_cast<SymbolId>(i));
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../common/thread_pool.h"
+#include "backward_chaining.h"
+
+// Answers batches of backward chaining queries concurrently.
+//
+// The service holds the current published snapshot together with its answer
+// cache. Each batch pins the version it started with, so a new snapshot can be
+// published while older batches are still running. Every worker thread owns a
+// ProofSearch scratch arena, and all workers share the answer cache of the
+// version they are querying, so subgoals proven by one query are reused by all
+// others.
+class QueryService
+{
+public:
+    explicit QueryService(size_t threads = std::thread::hardware_concurrency())
+        : pool(threads), searches(pool.size())
+    {
+    }
+
+    // Makes `snapshot` the version answered by new batches. Proven answers of
+    // the previous version are carried over only when the new snapshot extends
+    // it, i.e. is a newer one from the same BackwardChainer (see
+    // RuleSnapshot::extends); otherwise the new version starts empty.
+    void publish(std::shared_ptr<const RuleSnapshot> snapshot, bool keepProvenAnswers = true)
+    {
+        auto previous = current();
+        auto next = std::make_shared<Version>();
+        next->rules = std::move(snapshot);
+        next->answers = std::make_shared<AnswerCache>(
+            *next->rules, keepProvenAnswers && previous ? previous->answers.get() : nullptr);
+        std::atomic_store(&published, std::shared_ptr<const Version>(std::move(next)));
+    }
+
+    std::shared_ptr<const RuleSnapshot> snapshot() const
+    {
+        auto version = current();
+        return version ? version->rules : nullptr;
+    }
+
+    // Proves every goal of the batch; result[i] is 1 when goals[i] is provable.
+    // If `latencyMicros` is given it receives the service time of every query.
+    std::vector<uint8_t> proveBatch(const std::vector<SymbolId> &goals, std::vector<double> *latencyMicros = nullptr)
+    {
+        auto version = current();
+        if (!version)
+            return std::vector<uint8_t>(goals.size(), 0);
+        return run(*version, goals, latencyMicros);
+    }
+
+    // Same as above for goals given by name; unknown names are not provable
+    std::vector<uint8_t> proveBatch(const std::vector<std::string> &goals)
+    {
+        std::vector<uint8_t> results(goals.size(), 0);
+        auto version = current();
+        if (!version)
+            return results;
+
+        std::vector<SymbolId> ids;
+        std::vector<size_t> positions;
+        for (size_t i = 0; i < goals.size(); i++)
+        {
+            SymbolId id = version->rules->find(goals[i]);
+            if (id != NO_SYMBOL)
+            {
+                ids.push_back(id);
+                positions.push_back(i);
+            }
+        }
+        std::vector<uint8_t> proven = run(*version, ids, nullptr);
+        for (size_t k = 0; k < positions.size(); k++)
+            results[positions[k]] = proven[k];
+        return results;
+    }
+
+    size_t threads() const
+    {
+        return pool.size();
+    }
+
+private:
+    struct Version
+    {
+        std::shared_ptr<const RuleSnapshot> rules;
+        std::shared_ptr<AnswerCache> answers;
+    };
+
+    ThreadPool pool;
+    std::vector<ProofSearch> searches; // one scratch arena per worker
+    std::shared_ptr<const Version> published;
+
+    std::shared_ptr<const Version> current() const
+    {
+        return std::atomic_load(&published);
+    }
+
+    std::vector<uint8_t> run(const Version &version, const std::vector<SymbolId> &goals, std::vector<double> *latencyMicros)
+    {
+        AI_PHASE("query_service.batch");
+        std::vector<uint8_t> results(goals.size(), 0);
+        if (latencyMicros)
+            latencyMicros->assign(goals.size(), 0.0);
+
+        pool.parallelFor(
+            goals.size(),
+            [&](size_t worker, size_t i)
+            {
+                auto start = std::chrono::steady_clock::now();
+                results[i] = searches[worker].prove(*version.rules, *version.answers, goals[i]);
+                if (latencyMicros)
+                    (*latencyMicros)[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            },
+            16);
+        return results;
+    }
+};
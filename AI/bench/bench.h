@@ -0,0 +1,276 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../common/instrumentation.h"
+
+// Shared plumbing of the benchmark programs: command-line options, timing and
+// a JSON report.
+//
+// Every program takes "--name value" options and writes one JSON document:
+//
+//     {"benchmark": "puzzle",
+//      "parameters": {"seed": 42, "puzzles": 200, ...},
+//      "results": [{"name": "bfs", "seconds": 0.41, "expanded": 1832011, ...}, ...]}
+//
+// to stdout, or to the file given with --json. The parameters include the
+// defaults that were used, so two reports can always be compared, and
+// "instrumentation" tells whether the counters of instrumentation.h were
+// compiled in, since they slow the hot loops down slightly.
+
+inline double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+class BenchOptions
+{
+public:
+    BenchOptions(int argc, char *argv[])
+    {
+        for (int i = 1; i < argc; i += 2)
+        {
+            std::string name = argv[i];
+            if (name.size() < 3 || name.compare(0, 2, "--") != 0 || i + 1 >= argc)
+                throw std::invalid_argument("expected --<option> <value>, got " + name);
+            given.push_back({name.substr(2), argv[i + 1]});
+            used.push_back(false);
+        }
+    }
+
+    size_t get(const std::string &name, size_t fallback)
+    {
+        const std::string *text = find(name);
+        size_t value = text ? std::strtoull(text->c_str(), nullptr, 10) : fallback;
+        record(name, std::to_string(value));
+        return value;
+    }
+
+    double getReal(const std::string &name, double fallback)
+    {
+        const std::string *text = find(name);
+        double value = text ? std::strtod(text->c_str(), nullptr) : fallback;
+        record(name, number(value));
+        return value;
+    }
+
+    std::string getString(const std::string &name, const std::string &fallback)
+    {
+        const std::string *text = find(name);
+        std::string value = text ? *text : fallback;
+        record(name, quote(value));
+        return value;
+    }
+
+    // Throws if an option was given that the program did not ask for; call
+    // it once every option has been read
+    void rejectUnknown() const
+    {
+        for (size_t i = 0; i < given.size(); i++)
+        {
+            if (!used[i])
+                throw std::invalid_argument("unknown option --" + given[i].first);
+        }
+    }
+
+    // Options as name / JSON value pairs, in the order they were read
+    const std::vector<std::pair<std::string, std::string>> &values() const
+    {
+        return read;
+    }
+
+    static std::string number(double value)
+    {
+        if (!std::isfinite(value))
+            return "null";
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.9g", value);
+        return text;
+    }
+
+    static std::string quote(const std::string &text)
+    {
+        std::string json = "\"";
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                json += '\\';
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                json += escaped;
+            }
+            else
+            {
+                json += c;
+            }
+        }
+        return json + "\"";
+    }
+
+private:
+    std::vector<std::pair<std::string, std::string>> given;
+    std::vector<bool> used;
+    std::vector<std::pair<std::string, std::string>> read;
+
+    const std::string *find(const std::string &name)
+    {
+        const std::string *value = nullptr;
+        for (size_t i = 0; i < given.size(); i++)
+        {
+            if (given[i].first == name)
+            {
+                used[i] = true;
+                value = &given[i].second; // the last one wins
+            }
+        }
+        return value;
+    }
+
+    void record(const std::string &name, const std::string &json)
+    {
+        for (auto &entry : read)
+        {
+            if (entry.first == name)
+            {
+                entry.second = json;
+                return;
+            }
+        }
+        read.push_back({name, json});
+    }
+};
+
+class BenchReport
+{
+public:
+    // One measurement: named values in the order they were set
+    class Result
+    {
+    public:
+        explicit Result(const std::string &name)
+        {
+            set("name", name);
+        }
+
+        Result &set(const std::string &key, double value)
+        {
+            fields.push_back({key, BenchOptions::number(value)});
+            return *this;
+        }
+
+        Result &set(const std::string &key, size_t value)
+        {
+            fields.push_back({key, std::to_string(value)});
+            return *this;
+        }
+
+        Result &set(const std::string &key, bool value)
+        {
+            fields.push_back({key, value ? "true" : "false"});
+            return *this;
+        }
+
+        Result &set(const std::string &key, const std::string &value)
+        {
+            fields.push_back({key, BenchOptions::quote(value)});
+            return *this;
+        }
+
+        Result &set(const std::string &key, const char *value)
+        {
+            return set(key, std::string(value));
+        }
+
+        std::string json() const
+        {
+            return object(fields);
+        }
+
+    private:
+        std::vector<std::pair<std::string, std::string>> fields;
+    };
+
+    BenchReport(const std::string &benchmark, BenchOptions &options)
+        : benchmark(benchmark), options(options), path(options.getString("json", ""))
+    {
+    }
+
+    Result &add(const std::string &name)
+    {
+        results.emplace_back(name);
+        return results.back();
+    }
+
+    void write() const
+    {
+        std::vector<std::pair<std::string, std::string>> parameters;
+        for (const auto &entry : options.values())
+        {
+            if (entry.first != "json")
+                parameters.push_back(entry);
+        }
+        std::string json = "{\"benchmark\": " + BenchOptions::quote(benchmark) +
+                           ",\n \"instrumentation\": " + (INSTRUMENTED ? "true" : "false") +
+                           ",\n \"parameters\": " + object(parameters) + ",\n \"results\": [";
+        for (size_t i = 0; i < results.size(); i++)
+            json += (i == 0 ? "\n  " : ",\n  ") + results[i].json();
+        json += "]}\n";
+
+        if (path.empty())
+        {
+            std::cout << json;
+            return;
+        }
+        std::ofstream out(path);
+        out << json;
+        if (!out)
+            throw std::runtime_error("cannot write " + path);
+    }
+
+private:
+#if defined(AI_INSTRUMENTATION) && AI_INSTRUMENTATION
+    static constexpr bool INSTRUMENTED = true;
+#else
+    static constexpr bool INSTRUMENTED = false;
+#endif
+
+    std::string benchmark;
+    BenchOptions &options;
+    std::string path;
+    std::vector<Result> results;
+
+    static std::string object(const std::vector<std::pair<std::string, std::string>> &fields)
+    {
+        std::string json = "{";
+        for (size_t i = 0; i < fields.size(); i++)
+            json += (i == 0 ? "" : ", ") + BenchOptions::quote(fields[i].first) + ": " + fields[i].second;
+        return json + "}";
+    }
+};
+
+// Runs a benchmark body and turns exceptions into an error message and exit code 1
+template <class Body>
+int runBenchmark(Body body)
+{
+    try
+    {
+        body();
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,182 @@
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bench.h"
+#include "../common/search.h"
+#include "../Assignment4/a_star.h"
+#include "../Assignment4/contraction_hierarchy.h"
+#include "../Assignment4/grid_map.h"
+#include "../Assignment4/jump_point_search.h"
+#include "../Assignment4/landmarks.h"
+#include "../Assignment4/route_problem.h"
+
+using namespace std;
+
+// Usage: bench_astar [--road-nodes <n>] [--road-neighbors <n>] [--landmarks <n>]
+//                    [--grid-size <n>] [--obstacles <p>] [--queries <n>]
+//                    [--seed <n>] [--json <file>]
+// Random queries on a road-like network and on a random grid map, answered
+// by every shortest-path method for that kind of graph. Every method must
+// find the same distances as the first one.
+class Queries
+{
+public:
+    Queries(BenchReport &report, const string &graph, vector<pair<NodeId, NodeId>> pairs)
+        : report(report), graph(graph), pairs(std::move(pairs))
+    {
+    }
+
+    // `query(start, goal, settled)` returns the distance, or -1 if there is no
+    // path, and adds the nodes it settled to `settled`
+    template <class Query>
+    void measure(const string &method, Query query)
+    {
+        size_t settled = 0, mismatches = 0, unreachable = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < pairs.size(); i++)
+        {
+            double d = query(pairs[i].first, pairs[i].second, settled);
+            unreachable += d < 0;
+            if (reference.size() < pairs.size())
+                reference.push_back(d);
+            else
+                mismatches += abs(d - reference[i]) > 1e-6 * max(1.0, d);
+        }
+        double seconds = secondsSince(start);
+        report.add(graph + " " + method)
+            .set("queries", pairs.size())
+            .set("seconds", seconds)
+            .set("ms_per_query", seconds * 1000 / max<size_t>(pairs.size(), 1))
+            .set("settled_per_query", static_cast<double>(settled) / max<size_t>(pairs.size(), 1))
+            .set("unreachable", unreachable)
+            .set("mismatches", mismatches);
+    }
+
+private:
+    BenchReport &report;
+    string graph;
+    vector<pair<NodeId, NodeId>> pairs;
+    vector<double> reference;
+};
+
+int main(int argc, char *argv[])
+{
+    return runBenchmark([&]
+                        {
+        BenchOptions options(argc, argv);
+        BenchReport report("astar", options);
+        size_t roadNodes = options.get("road-nodes", 100000);
+        size_t roadNeighbors = options.get("road-neighbors", 3);
+        size_t landmarkCount = options.get("landmarks", 8);
+        size_t gridSize = options.get("grid-size", 512);
+        double obstacles = options.getReal("obstacles", 0.25);
+        size_t queries = options.get("queries", 100);
+        unsigned seed = static_cast<unsigned>(options.get("seed", 42));
+        options.rejectUnknown();
+        mt19937 rng(seed);
+
+        if (roadNodes > 1)
+        {
+            auto start = chrono::steady_clock::now();
+            Graph g = makeRoadNetwork(roadNodes, roadNeighbors, seed);
+            report.add("road build").set("nodes", g.nodeCount()).set("arcs", g.arcCount()).set("seconds", secondsSince(start));
+
+            uniform_int_distribution<NodeId> pick(0, static_cast<NodeId>(g.nodeCount() - 1));
+            vector<pair<NodeId, NodeId>> pairs(queries);
+            for (auto &q : pairs)
+                q = {pick(rng), pick(rng)};
+            Queries road(report, "road", pairs);
+
+            SearchContext context;
+            road.measure("dijkstra", [&](NodeId from, NodeId to, size_t &settled)
+                         {
+                             bool found = context.aStar(g, from, to, ZeroHeuristic{});
+                             settled += context.settledCount();
+                             return found ? context.distance(to) : -1.0; });
+            CoordinateHeuristic model(g, Metric::Euclidean);
+            road.measure("astar coordinates", [&](NodeId from, NodeId to, size_t &settled)
+                         {
+                             bool found = context.aStar(g, from, to, model.towards(to));
+                             settled += context.settledCount();
+                             return found ? context.distance(to) : -1.0; });
+            Search<RouteProblem<CoordinateHeuristic::Towards>> generic;
+            road.measure("generic astar coordinates", [&](NodeId from, NodeId to, size_t &settled)
+                         {
+                             bool found = generic.aStar(makeRouteProblem(g, to, model.towards(to)), from);
+                             settled += generic.expandedCount();
+                             return found ? generic.cost() : -1.0; });
+            Graph reverse = g.reversed();
+            BidirectionalSearchContext both;
+            road.measure("bidirectional astar coordinates", [&](NodeId from, NodeId to, size_t &settled)
+                         {
+                             bool found = both.aStar(g, reverse, from, to, model.towards(to), model.from(from));
+                             settled += both.settledCount();
+                             return found ? both.distance() : -1.0; });
+            if (landmarkCount > 0)
+            {
+                start = chrono::steady_clock::now();
+                Landmarks alt = Landmarks::build(g, landmarkCount, Landmarks::Selection::Avoid, seed);
+                report.add("road landmarks").set("landmarks", alt.count()).set("seconds", secondsSince(start));
+                road.measure("astar alt", [&](NodeId from, NodeId to, size_t &settled)
+                             {
+                                 bool found = context.aStar(g, from, to, alt.towards(to));
+                                 settled += context.settledCount();
+                                 return found ? context.distance(to) : -1.0; });
+            }
+            start = chrono::steady_clock::now();
+            ContractionHierarchy ch = ContractionHierarchy::build(g);
+            report.add("road contraction").set("shortcuts", ch.shortcutCount()).set("seconds", secondsSince(start));
+            HierarchySearchContext hierarchy;
+            road.measure("contraction hierarchy", [&](NodeId from, NodeId to, size_t &settled)
+                         {
+                             bool found = hierarchy.query(ch, from, to);
+                             settled += hierarchy.settledCount();
+                             return found ? hierarchy.distance() : -1.0; });
+        }
+
+        if (gridSize > 1)
+        {
+            int side = static_cast<int>(gridSize);
+            GridMap map = makeRandomGridMap(side, side, obstacles, seed);
+            vector<NodeId> open;
+            for (NodeId c = 0; c < map.cellCount(); c++)
+            {
+                if (map.passable(map.x(c), map.y(c)))
+                    open.push_back(c);
+            }
+            if (open.empty())
+                throw invalid_argument("the grid has no free cell");
+            uniform_int_distribution<size_t> pick(0, open.size() - 1);
+            vector<pair<NodeId, NodeId>> pairs(queries);
+            for (auto &q : pairs)
+                q = {open[pick(rng)], open[pick(rng)]};
+            Queries grid(report, "grid", pairs);
+
+            Graph g = map.toGraph();
+            SearchContext context;
+            grid.measure("astar explicit graph", [&](NodeId from, NodeId to, size_t &settled)
+                         {
+                             bool found = context.aStar(g, from, to, map.towards(to));
+                             settled += context.settledCount();
+                             return found ? context.distance(to) : -1.0; });
+            GridSearch search;
+            grid.measure("astar implicit grid", [&](NodeId from, NodeId to, size_t &settled)
+                         {
+                             bool found = search.aStar(map, from, to);
+                             settled += search.settledCount();
+                             return found ? search.distance(to) : -1.0; });
+            grid.measure("jps cellwise", [&](NodeId from, NodeId to, size_t &settled)
+                         {
+                             bool found = search.jumpPointSearch(map, from, to, GridSearch::Scan::Cellwise);
+                             settled += search.settledCount();
+                             return found ? search.distance(to) : -1.0; });
+            grid.measure("jps bit-parallel", [&](NodeId from, NodeId to, size_t &settled)
+                         {
+                             bool found = search.jumpPointSearch(map, from, to, GridSearch::Scan::BitParallel);
+                             settled += search.settledCount();
+                             return found ? search.distance(to) : -1.0; });
+        }
+        report.write(); });
+}
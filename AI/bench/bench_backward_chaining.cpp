@@ -0,0 +1,77 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "../Assignment8/backward_chaining.h"
+
+using namespace std;
+
+// Usage: bench_backward_chaining [--chain-depth <n>] [--wide-rules <n>]
+//                                [--layers <n>] [--width <n>] [--conditions <n>]
+//                                [--queries <n>] [--seed <n>] [--json <file>]
+// Proves goals on a long chain, a wide random rule base with cycles and a
+// layered rule base. Each shape is queried twice: the cold pass fills the
+// answer table, the warm pass only reads it.
+void prove(BenchReport &report, const string &shape, BackwardChainer &kb, const vector<SymbolId> &goals,
+           size_t expectedProven)
+{
+    for (const char *pass : {"cold", "warm"})
+    {
+        size_t proven = 0;
+        auto start = chrono::steady_clock::now();
+        for (SymbolId goal : goals)
+            proven += kb.backwardChain(goal);
+        double seconds = secondsSince(start);
+        auto &result = report.add(shape + " " + pass)
+                           .set("rules", kb.ruleCount())
+                           .set("queries", goals.size())
+                           .set("seconds", seconds)
+                           .set("us_per_query", seconds * 1e6 / max<size_t>(goals.size(), 1))
+                           .set("proven", proven);
+        if (expectedProven != SIZE_MAX)
+            result.set("correct", proven == expectedProven);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    return runBenchmark([&]
+                        {
+        BenchOptions options(argc, argv);
+        BenchReport report("backward_chaining", options);
+        size_t depth = options.get("chain-depth", 1000000);
+        size_t wideRules = options.get("wide-rules", 1000000);
+        size_t layers = options.get("layers", 100);
+        size_t width = options.get("width", 1000);
+        size_t conditions = options.get("conditions", 3);
+        size_t queries = options.get("queries", 10000);
+        unsigned seed = static_cast<unsigned>(options.get("seed", 42));
+        options.rejectUnknown();
+
+        {
+            BackwardChainer kb;
+            vector<SymbolId> goals{makeChainRuleBase(kb, depth)};
+            prove(report, "chain", kb, goals, 1);
+        }
+        mt19937 rng(seed);
+        {
+            BackwardChainer kb;
+            makeWideRuleBase(kb, wideRules, seed);
+            vector<SymbolId> goals(queries);
+            for (auto &goal : goals)
+                goal = static_cast<SymbolId>(rng() % kb.symbolCount());
+            prove(report, "wide", kb, goals, SIZE_MAX);
+        }
+        if (layers > 0 && width > 0)
+        {
+            // Goals from the top layer; every symbol of a layered base can be proven
+            BackwardChainer kb;
+            makeLayeredRuleBase(kb, layers, width, max<size_t>(conditions, 1), seed);
+            vector<SymbolId> goals(queries);
+            for (auto &goal : goals)
+                goal = static_cast<SymbolId>((layers - 1) * width + rng() % width);
+            prove(report, "layered", kb, goals, goals.size());
+        }
+        report.write(); });
+}
@@ -0,0 +1,39 @@
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "bench.h"
+#include "../Assignment7/forward_chaining.h"
+
+using namespace std;
+
+// Usage: bench_forward_chaining [--layers <n>] [--width <n>] [--conditions <n>]
+//                               [--seed <n>] [--json <file>]
+// Forward chains over a layered rule base until everything is derived.
+int main(int argc, char *argv[])
+{
+    return runBenchmark([&]
+                        {
+        BenchOptions options(argc, argv);
+        BenchReport report("forward_chaining", options);
+        size_t layers = options.get("layers", 50);
+        size_t width = options.get("width", 1000);
+        size_t conditions = options.get("conditions", 3);
+        unsigned seed = static_cast<unsigned>(options.get("seed", 42));
+        options.rejectUnknown();
+
+        unordered_set<string> facts;
+        auto start = chrono::steady_clock::now();
+        vector<Rule> rules = makeLayeredRules(layers, width, max<size_t>(conditions, 1), seed, facts);
+        double buildSeconds = secondsSince(start);
+
+        start = chrono::steady_clock::now();
+        size_t derived = forwardChain(rules, facts, [](const string &) {});
+        double seconds = secondsSince(start);
+        report.add("layered")
+            .set("rules", rules.size())
+            .set("build_seconds", buildSeconds)
+            .set("seconds", seconds)
+            .set("derived", derived)
+            .set("complete", derived == rules.size());
+        report.write(); });
+}
@@ -0,0 +1,66 @@
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "../Assignment2/graph_coloring.h"
+
+using namespace std;
+
+// Usage: bench_graph_color [--regions <n>] [--densities <p,p,...>] [--colors <n>]
+//                          [--instances <n>] [--seed <n>] [--json <file>]
+// Colors random maps of each edge density with backtracking and checks every
+// coloring found.
+int main(int argc, char *argv[])
+{
+    return runBenchmark([&]
+                        {
+        BenchOptions options(argc, argv);
+        BenchReport report("graph_color", options);
+        int regions = static_cast<int>(options.get("regions", 40));
+        string densities = options.getString("densities", "0.02,0.05,0.08,0.1");
+        int colors = static_cast<int>(options.get("colors", 4));
+        size_t instances = options.get("instances", 20);
+        unsigned seed = static_cast<unsigned>(options.get("seed", 42));
+        options.rejectUnknown();
+
+        for (const char *p = densities.c_str(); *p;)
+        {
+            char *end;
+            double density = strtod(p, &end);
+            if (end == p)
+                throw invalid_argument("bad density list: " + densities);
+            p = *end == ',' ? end + 1 : end;
+
+            vector<GraphColoringCSP> maps;
+            size_t constraints = 0;
+            for (size_t i = 0; i < instances; i++)
+            {
+                maps.push_back(makeRandomColoring(regions, density, colors, seed + static_cast<unsigned>(i)));
+                constraints += maps.back().constraintCount();
+            }
+
+            size_t solved = 0, invalid = 0;
+            auto start = chrono::steady_clock::now();
+            for (auto &csp : maps)
+            {
+                if (!csp.solve())
+                    continue;
+                solved++;
+                for (int r = 0; r < regions; r++)
+                {
+                    // Every region colored and different from each neighbour colored before it
+                    if (csp.color(r) == GraphColoringCSP::NO_COLOR || !csp.isConsistent(r, csp.color(r)))
+                        invalid++;
+                }
+            }
+            double seconds = secondsSince(start);
+            report.add("density " + BenchOptions::number(density))
+                .set("density", density)
+                .set("instances", instances)
+                .set("mean_constraints", static_cast<double>(constraints) / max<size_t>(instances, 1))
+                .set("seconds", seconds)
+                .set("solved", solved)
+                .set("invalid", invalid);
+        }
+        report.write(); });
+}
@@ -0,0 +1,150 @@
+#include <random>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "../Assignment3/family_service.h"
+#include "../Assignment3/knowledge_base.h"
+
+using namespace std;
+
+// Usage: bench_kinship [--people <n>] [--generation <n>] [--queries <n>]
+//                      [--deep-queries <n>] [--seed <n>] [--json <file>]
+// Builds a synthetic family tree and times every relation and kinship query
+// on random people, then the incremental refreeze after adding 0.1% more,
+// and the latency of publishing batches of 1 to 10000 new links to a
+// FamilyService that serves the same tree.
+// Queries that reach far up or down the tree (deep ancestors, distant
+// cousins) run on the first --deep-queries people only.
+int main(int argc, char *argv[])
+{
+    return runBenchmark([&]
+                        {
+        BenchOptions options(argc, argv);
+        BenchReport report("kinship", options);
+        size_t people = options.get("people", 200000);
+        size_t generation = max<size_t>(options.get("generation", 1000), 2);
+        size_t queries = options.get("queries", 200000);
+        size_t deepQueries = min(options.get("deep-queries", 5000), queries);
+        unsigned seed = static_cast<unsigned>(options.get("seed", 42));
+        options.rejectUnknown();
+        if (people < 25 * generation)
+            throw invalid_argument("people must cover at least 25 generations");
+
+        KnowledgeBase kb;
+        auto start = chrono::steady_clock::now();
+        makeFamilyTree(kb, people, generation, seed);
+        double generated = secondsSince(start);
+        start = chrono::steady_clock::now();
+        auto family = kb.snapshot();
+        report.add("build")
+            .set("people", kb.personCount())
+            .set("links", family->linkCount())
+            .set("generate_seconds", generated)
+            .set("index_seconds", secondsSince(start));
+
+        // The second person of a pair is from the same generation
+        mt19937 rng(seed + 1);
+        vector<PersonId> persons(queries), others(queries);
+        for (size_t i = 0; i < queries; i++)
+        {
+            persons[i] = static_cast<PersonId>(rng() % people);
+            others[i] = static_cast<PersonId>(persons[i] / generation * generation + rng() % generation);
+        }
+
+        KinshipSearch search;
+        const KinshipIndex &index = kb.kinship();
+        auto measureOn = [&](size_t count, const char *relation, auto query)
+        {
+            size_t found = 0;
+            auto begin = chrono::steady_clock::now();
+            for (size_t i = 0; i < count; i++)
+                found += query(persons[i], others[i]);
+            double seconds = secondsSince(begin);
+            report.add(relation)
+                .set("queries", count)
+                .set("seconds", seconds)
+                .set("ns_per_query", seconds * 1e9 / max<size_t>(count, 1))
+                .set("results_per_query", static_cast<double>(found) / max<size_t>(count, 1));
+        };
+        auto measure = [&](const char *relation, auto query)
+        { measureOn(queries, relation, query); };
+        auto measureDeep = [&](const char *relation, auto query)
+        { measureOn(deepQueries, relation, query); };
+        // Whether the person `generations` generations above q's is an ancestor of p
+        auto ancestorTest = [&](uint32_t generations)
+        {
+            return [&, generations](PersonId p, PersonId q)
+            {
+                size_t shift = size_t(generations) * generation;
+                return size_t(q >= shift && search.isAncestor(*family, index, static_cast<PersonId>(q - shift), p));
+            };
+        };
+        measure("children", [&](PersonId p, PersonId)
+                { return family->children(p).size(); });
+        measure("parents", [&](PersonId p, PersonId)
+                { return family->parents(p).size(); });
+        measure("grandparents", [&](PersonId p, PersonId)
+                { return search.grandparents(*family, p).size(); });
+        measure("siblings", [&](PersonId p, PersonId)
+                { return search.siblings(*family, p).size(); });
+        measure("uncles/aunts", [&](PersonId p, PersonId)
+                { return search.unclesAunts(*family, p).size(); });
+        measure("nephews/nieces", [&](PersonId p, PersonId)
+                { return search.nephewsNieces(*family, p).size(); });
+        measure("is ancestor (4 generations up)", ancestorTest(4));
+        measure("is ancestor (8 generations up)", ancestorTest(8));
+        measureDeep("is ancestor (20 generations up)", ancestorTest(20));
+        measure("ancestors 3 links up", [&](PersonId p, PersonId)
+                { return search.ancestorsAt(*family, index, p, 3).size(); });
+        measureDeep("ancestors 12 links up", [&](PersonId p, PersonId)
+                    { return search.ancestorsAt(*family, index, p, 12).size(); });
+        measure("related within 4 links", [&](PersonId p, PersonId q)
+                { return size_t(search.relationship(*family, p, q, 4).related()); });
+        measure("first cousins", [&](PersonId p, PersonId)
+                { return search.cousins(*family, p, 1, 0).size(); });
+        measureDeep("first cousins once removed", [&](PersonId p, PersonId)
+                    { return search.cousins(*family, p, 1, 1).size(); });
+        measureDeep("second cousins", [&](PersonId p, PersonId)
+                    { return search.cousins(*family, p, 2, 0).size(); });
+        measureDeep("third cousins", [&](PersonId p, PersonId)
+                    { return search.cousins(*family, p, 3, 0).size(); });
+        measureDeep("fourth cousins", [&](PersonId p, PersonId)
+                    { return search.cousins(*family, p, 4, 0).size(); });
+
+        size_t added = max<size_t>(people / 1000, 1);
+        for (size_t i = 0; i < added; i++)
+        {
+            PersonId child = kb.intern("new" + to_string(i));
+            kb.addParent(static_cast<PersonId>(rng() % people), child);
+            kb.addParent(static_cast<PersonId>(rng() % people), child);
+        }
+        start = chrono::steady_clock::now();
+        kb.snapshot();
+        report.add("refreeze").set("added", added).set("seconds", secondsSince(start));
+
+        FamilyService service;
+        service.addRecords(kb.release());
+        service.publish();
+        for (size_t batch : {1, 10, 100, 1000, 10000})
+        {
+            const size_t publishes = 20;
+            double seconds = 0;
+            for (size_t round = 0; round < publishes; round++)
+            {
+                for (size_t i = 0; i < batch; i++)
+                {
+                    string child = "b" + to_string(batch) + "_" + to_string(round) + "_" + to_string(i);
+                    service.addParent("p" + to_string(rng() % people), child);
+                }
+                auto begin = chrono::steady_clock::now();
+                service.publish();
+                seconds += secondsSince(begin);
+                service.retiredVersions();
+            }
+            report.add("publish " + to_string(batch) + " links")
+                .set("publishes", publishes)
+                .set("seconds", seconds)
+                .set("ms_per_publish", seconds * 1e3 / publishes);
+        }
+        report.write(); });
+}
@@ -0,0 +1,55 @@
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "../Assignment2/n_queens.h"
+
+using namespace std;
+
+// Usage: bench_nqueens [--sizes <n,n,...>] [--repeat <n>] [--json <file>]
+// Times the backtracking search for the first solution of each board size
+// and checks the queens it places.
+int main(int argc, char *argv[])
+{
+    return runBenchmark([&]
+                        {
+        BenchOptions options(argc, argv);
+        BenchReport report("nqueens", options);
+        string sizes = options.getString("sizes", "8,12,16,20,24,27");
+        size_t repeat = options.get("repeat", 3);
+        options.rejectUnknown();
+
+        for (const char *p = sizes.c_str(); *p;)
+        {
+            char *end;
+            int n = static_cast<int>(strtol(p, &end, 10));
+            if (end == p || n <= 0)
+                throw invalid_argument("bad size list: " + sizes);
+            p = *end == ',' ? end + 1 : end;
+
+            bool solved = false, valid = true;
+            auto start = chrono::steady_clock::now();
+            for (size_t r = 0; r < repeat; r++)
+            {
+                NQueensCSP csp(n);
+                const auto &assignment = csp.solve();
+                solved = !assignment.empty();
+                for (const auto &a : assignment)
+                {
+                    for (const auto &b : assignment)
+                    {
+                        if (a.first != b.first && (a.second == b.second || abs(a.first - b.first) == abs(a.second - b.second)))
+                            valid = false;
+                    }
+                }
+                valid = valid && (!solved || static_cast<int>(assignment.size()) == n);
+            }
+            double seconds = secondsSince(start) / max<size_t>(repeat, 1);
+            report.add(to_string(n) + "-queens")
+                .set("n", static_cast<size_t>(n))
+                .set("seconds", seconds)
+                .set("solved", solved)
+                .set("valid", valid);
+        }
+        report.write(); });
+}
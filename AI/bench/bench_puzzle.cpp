@@ -0,0 +1,109 @@
+#include <random>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "../common/search.h"
+#include "../Assignment1/sliding_puzzle.h"
+
+using namespace std;
+
+// Usage: bench_puzzle [--seed <n>] [--puzzles <n>] [--iddfs-puzzles <n>]
+//                     [--fifteen <n>] [--fifteen-walk <moves>] [--json <file>]
+// Solves random solvable 8-puzzles with every engine of search.h and random
+// walks away from the 15-puzzle goal with IDA*. All optimal engines must
+// agree on the solution lengths.
+template <class Puzzle>
+void solveAll(BenchReport &report, const string &name, const Puzzle &puzzle, const vector<uint64_t> &starts,
+              vector<size_t> &lengths, bool optimal, bool (*solve)(Search<Puzzle> &, const Puzzle &, uint64_t))
+{
+    Search<Puzzle> search;
+    size_t expanded = 0, generated = 0, stored = 0, moves = 0, unsolved = 0, mismatches = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < starts.size(); i++)
+    {
+        if (!solve(search, puzzle, starts[i]))
+        {
+            unsolved++;
+            continue;
+        }
+        expanded += search.expandedCount();
+        generated += search.generatedCount();
+        stored = max(stored, search.storedCount());
+        moves += search.path().size() - 1;
+        if (lengths.size() <= i)
+            lengths.push_back(search.path().size() - 1);
+        else if (optimal && lengths[i] != search.path().size() - 1)
+            mismatches++;
+    }
+    double seconds = secondsSince(start);
+    size_t solved = starts.size() - unsolved;
+    report.add(name)
+        .set("puzzles", starts.size())
+        .set("seconds", seconds)
+        .set("us_per_puzzle", seconds * 1e6 / max<size_t>(starts.size(), 1))
+        .set("expanded", expanded)
+        .set("generated", generated)
+        .set("max_stored", stored)
+        .set("mean_moves", static_cast<double>(moves) / max<size_t>(solved, 1))
+        .set("unsolved", unsolved)
+        .set("mismatches", mismatches);
+}
+
+int main(int argc, char *argv[])
+{
+    return runBenchmark([&]
+                        {
+        BenchOptions options(argc, argv);
+        BenchReport report("puzzle", options);
+        unsigned seed = static_cast<unsigned>(options.get("seed", 42));
+        size_t puzzles = options.get("puzzles", 100);
+        size_t iddfsPuzzles = options.get("iddfs-puzzles", 10);
+        size_t fifteen = options.get("fifteen", 10);
+        size_t walk = options.get("fifteen-walk", 60);
+        options.rejectUnknown();
+
+        mt19937_64 rng(seed);
+        vector<uint64_t> starts(puzzles);
+        for (auto &s : starts)
+            s = EightPuzzle::random(rng);
+
+        // The first optimal engine fills the lengths the others are checked against
+        EightPuzzle puzzle;
+        vector<size_t> lengths;
+        solveAll<EightPuzzle>(report, "8-puzzle bfs", puzzle, starts, lengths, true, [](auto &s, auto &p, uint64_t x)
+                              { return s.breadthFirst(p, x); });
+        solveAll<EightPuzzle>(report, "8-puzzle astar", puzzle, starts, lengths, true, [](auto &s, auto &p, uint64_t x)
+                              { return s.aStar(p, x); });
+        solveAll<EightPuzzle>(report, "8-puzzle idastar", puzzle, starts, lengths, true, [](auto &s, auto &p, uint64_t x)
+                              { return s.idaStar(p, x); });
+        solveAll<EightPuzzle>(report, "8-puzzle ucs", puzzle, starts, lengths, true, [](auto &s, auto &p, uint64_t x)
+                              { return s.uniformCost(p, x); });
+        // Every 8-puzzle is solvable within 31 moves
+        solveAll<EightPuzzle>(report, "8-puzzle dfs", puzzle, starts, lengths, false, [](auto &s, auto &p, uint64_t x)
+                              { return s.depthFirst(p, x, 31); });
+        vector<uint64_t> few(starts.begin(), starts.begin() + min(iddfsPuzzles, starts.size()));
+        solveAll<EightPuzzle>(report, "8-puzzle iddfs", puzzle, few, lengths, true, [](auto &s, auto &p, uint64_t x)
+                              { return s.iterativeDeepening(p, x, 31); });
+
+        // Random walks from the goal, so the instances stay within reach of IDA*
+        SlidingPuzzle<4> puzzle15;
+        vector<uint64_t> starts15(fifteen);
+        for (auto &s : starts15)
+        {
+            s = puzzle15.goalState();
+            vector<uint64_t> next;
+            for (size_t m = 0; m < walk; m++)
+            {
+                next.clear();
+                puzzle15.successors(s, [&](uint64_t n, uint32_t)
+                                    { next.push_back(n); });
+                s = next[rng() % next.size()];
+            }
+        }
+        vector<size_t> lengths15;
+        solveAll<SlidingPuzzle<4>>(report, "15-puzzle idastar", puzzle15, starts15, lengths15, true, [](auto &s, auto &p, uint64_t x)
+                                   { return s.idaStar(p, x); });
+        solveAll<SlidingPuzzle<4>>(report, "15-puzzle astar", puzzle15, starts15, lengths15, true, [](auto &s, auto &p, uint64_t x)
+                                   { return s.aStar(p, x); });
+        report.write(); });
+}
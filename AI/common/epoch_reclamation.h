@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Epoch-based reclamation for data that readers reach through an atomic
+// pointer while writers replace it.
+//
+// A reader announces the global epoch in its own slot while it holds such
+// pointers (between enter() and exit()). That is one store to a cache line no
+// other thread writes, with no locks and no shared reference counts, so reads
+// scale with the number of cores. A writer first unpublishes an object and
+// then retire()s it. The object is destroyed once every reader that may
+// still see it has left: all readers inside at the time announced an epoch
+// no later than the one it was retired in.
+class EpochDomain
+{
+public:
+    // One per reader thread
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> epoch{IDLE};
+        bool inUse = true;
+    };
+
+    EpochDomain() = default;
+    EpochDomain(const EpochDomain &) = delete;
+    EpochDomain &operator=(const EpochDomain &) = delete;
+
+    // Destroys everything still retired; no reader may be inside any more
+    ~EpochDomain()
+    {
+        for (auto &entry : retired)
+            entry.second();
+    }
+
+    Slot *registerReader()
+    {
+        std::lock_guard<std::mutex> lock(slotsMutex);
+        for (auto &slot : slots)
+        {
+            if (!slot->inUse)
+            {
+                slot->inUse = true;
+                return slot.get();
+            }
+        }
+        slots.push_back(std::make_unique<Slot>());
+        return slots.back().get();
+    }
+
+    void unregisterReader(Slot *slot)
+    {
+        std::lock_guard<std::mutex> lock(slotsMutex);
+        slot->epoch.store(IDLE, std::memory_order_release);
+        slot->inUse = false;
+    }
+
+    // Must come before loading any protected pointer. Both are sequentially
+    // consistent, so a writer that no longer sees this reader's slot has
+    // already published what the reader will load.
+    void enter(Slot *slot) const
+    {
+        slot->epoch.store(globalEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    }
+
+    void exit(Slot *slot) const
+    {
+        slot->epoch.store(IDLE, std::memory_order_release);
+    }
+
+    // Hands over an object that was just unpublished; `destroy` is called
+    // once no reader can see it any more
+    void retire(std::function<void()> destroy)
+    {
+        uint64_t epoch = globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+        {
+            std::lock_guard<std::mutex> lock(retiredMutex);
+            retired.emplace_back(epoch, std::move(destroy));
+        }
+        collect();
+    }
+
+    // Destroys what no reader can see any more; returns how many retired
+    // objects are left
+    size_t collect()
+    {
+        uint64_t oldestReader = IDLE;
+        {
+            std::lock_guard<std::mutex> lock(slotsMutex);
+            for (auto &slot : slots)
+                oldestReader = std::min(oldestReader, slot->epoch.load(std::memory_order_seq_cst));
+        }
+        std::vector<std::function<void()>> ready;
+        size_t left;
+        {
+            std::lock_guard<std::mutex> lock(retiredMutex);
+            auto keep = retired.begin();
+            for (auto &entry : retired)
+            {
+                // A reader that announced epoch e > entry.first entered after
+                // the object had been unpublished
+                if (entry.first < oldestReader)
+                    ready.push_back(std::move(entry.second));
+                else
+                    *keep++ = std::move(entry);
+            }
+            retired.erase(keep, retired.end());
+            left = retired.size();
+        }
+        for (auto &destroy : ready)
+            destroy();
+        return left;
+    }
+
+private:
+    static constexpr uint64_t IDLE = std::numeric_limits<uint64_t>::max();
+
+    std::atomic<uint64_t> globalEpoch{1};
+    std::mutex slotsMutex;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::mutex retiredMutex;
+    std::vector<std::pair<uint64_t, std::function<void()>>> retired;
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "instrumentation.h"
+
+// Indexed d-ary min-heap over dense ids (0 .. capacity - 1).
+// Every id is in the heap at most once and its position is tracked, so keys can
+// be decreased in O(log_d n) instead of pushing duplicates. A wider node (d = 4)
+// makes the tree shallower and keeps sift-down comparisons within one cache line.
+//
+// Positions of ids that are not in the heap are kept at NOT_IN_HEAP, so clear()
+// only touches the ids still queued and a heap can be reused across searches.
+// Pushes, pops and decreased keys count as HeapOperations in instrumentation.h;
+// they are tallied in the heap and reported when it is cleared or destroyed.
+template <class Key, unsigned Arity = 4>
+class IndexedDaryHeap
+{
+public:
+    static constexpr uint32_t NOT_IN_HEAP = std::numeric_limits<uint32_t>::max();
+
+    explicit IndexedDaryHeap(size_t capacity = 0) : position(capacity, NOT_IN_HEAP) {}
+
+    // Makes room for ids below `capacity`
+    void reserveIds(size_t capacity)
+    {
+        if (position.size() < capacity)
+            position.resize(capacity, NOT_IN_HEAP);
+    }
+
+    bool empty() const
+    {
+        return heap.empty();
+    }
+
+    size_t size() const
+    {
+        return heap.size();
+    }
+
+    bool contains(uint32_t id) const
+    {
+        return position[id] != NOT_IN_HEAP;
+    }
+
+    Key key(uint32_t id) const
+    {
+        return heap[position[id]].key;
+    }
+
+    uint32_t top() const
+    {
+        return heap.front().id;
+    }
+
+    Key topKey() const
+    {
+        return heap.front().key;
+    }
+
+    void push(uint32_t id, Key key)
+    {
+        operations.add();
+        position[id] = static_cast<uint32_t>(heap.size());
+        heap.push_back({key, id});
+        siftUp(position[id]);
+    }
+
+    // The new key must not be larger than the current one
+    void decreaseKey(uint32_t id, Key key)
+    {
+        operations.add();
+        heap[position[id]].key = key;
+        siftUp(position[id]);
+    }
+
+    // Inserts `id` or lowers its key; returns false if the current key is already lower or equal
+    bool pushOrDecrease(uint32_t id, Key key)
+    {
+        if (!contains(id))
+        {
+            push(id, key);
+            return true;
+        }
+        if (!(key < heap[position[id]].key))
+            return false;
+        decreaseKey(id, key);
+        return true;
+    }
+
+    uint32_t pop()
+    {
+        operations.add();
+        uint32_t id = heap.front().id;
+        position[id] = NOT_IN_HEAP;
+        Entry last = heap.back();
+        heap.pop_back();
+        if (!heap.empty())
+        {
+            heap.front() = last;
+            position[last.id] = 0;
+            siftDown(0);
+        }
+        return id;
+    }
+
+    void clear()
+    {
+        operations.flush();
+        for (const Entry &e : heap)
+            position[e.id] = NOT_IN_HEAP;
+        heap.clear();
+    }
+
+private:
+    struct Entry
+    {
+        Key key;
+        uint32_t id;
+    };
+
+    std::vector<Entry> heap;
+    std::vector<uint32_t> position;
+    CounterTally<Counter::HeapOperations> operations;
+
+    void siftUp(uint32_t i)
+    {
+        Entry moving = heap[i];
+        while (i > 0)
+        {
+            uint32_t parent = (i - 1) / Arity;
+            if (!(moving.key < heap[parent].key))
+                break;
+            heap[i] = heap[parent];
+            position[heap[i].id] = i;
+            i = parent;
+        }
+        heap[i] = moving;
+        position[moving.id] = i;
+    }
+
+    void siftDown(uint32_t i)
+    {
+        Entry moving = heap[i];
+        size_t n = heap.size();
+        for (;;)
+        {
+            size_t first = static_cast<size_t>(i) * Arity + 1;
+            if (first >= n)
+                break;
+            size_t last = first + Arity < n ? first + Arity : n;
+            size_t best = first;
+            for (size_t c = first + 1; c < last; c++)
+            {
+                if (heap[c].key < heap[best].key)
+                    best = c;
+            }
+            if (!(heap[best].key < moving.key))
+                break;
+            heap[i] = heap[best];
+            position[heap[i].id] = i;
+            i = static_cast<uint32_t>(best);
+        }
+        heap[i] = moving;
+        position[moving.id] = i;
+    }
+};
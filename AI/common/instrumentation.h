@@ -0,0 +1,425 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Counters and phase timers for the search and inference engines, compiled in
+// only when AI_INSTRUMENTATION is defined to 1 (cmake -DAI_INSTRUMENTATION=ON).
+// Otherwise the macros below expand to nothing and cost nothing.
+//
+//     AI_COUNT(NodesExpanded);           // one event
+//     AI_COUNT_ADD(NodesGenerated, n);   // n events
+//     AI_PHASE("search.astar");          // times the enclosing scope
+//
+// Counters are per thread: each thread bumps its own cache line with a
+// relaxed load and store (a plain increment, no lock prefix), and totals are
+// summed only when stats are exported. Phases record calls, total and longest
+// time, and the peak memory of the process, sampled at most once a
+// millisecond per thread when a phase ends. Phase names must be string
+// literals. Keep phases around whole searches or batches, not single steps.
+//
+// At exit the stats go to the file named by the AI_STATS environment variable
+// as JSON lines (one per thread, then the totals), and a Chrome trace of every
+// phase (chrome://tracing or ui.perfetto.dev) to the file named by AI_TRACE.
+// Programs can also call Instrumentation::writeJsonLines / writeChromeTrace.
+
+enum class Counter : unsigned
+{
+    NodesExpanded,
+    NodesGenerated,
+    DuplicatesPruned,
+    Backtracks,
+    RuleFirings,
+    HeapOperations,
+    Count
+};
+
+inline const char *counterName(Counter counter)
+{
+    static const char *const names[] = {"nodes_expanded", "nodes_generated", "duplicates_pruned",
+                                        "backtracks",     "rule_firings",    "heap_operations"};
+    return names[static_cast<unsigned>(counter)];
+}
+
+class Instrumentation
+{
+public:
+    static constexpr size_t COUNTERS = static_cast<size_t>(Counter::Count);
+    static constexpr size_t MAX_TRACE_EVENTS = size_t(1) << 20; // per thread
+
+    static void add(Counter counter, uint64_t n = 1)
+    {
+        std::atomic<uint64_t> &c = local().counters[static_cast<size_t>(counter)];
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    // Sum over all threads
+    static uint64_t total(Counter counter)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        uint64_t sum = 0;
+        for (auto &t : r.threads)
+            sum += t->counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    // Records every phase as a trace event, not only the per-name totals
+    static void setTracing(bool on)
+    {
+        registry().tracing.store(on, std::memory_order_relaxed);
+    }
+
+    // Clears all counters, phases and trace events
+    static void reset()
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto &t : r.threads)
+        {
+            std::lock_guard<std::mutex> phaseLock(t->mutex);
+            for (auto &c : t->counters)
+                c.store(0, std::memory_order_relaxed);
+            t->phases.clear();
+            t->events.clear();
+            t->droppedEvents = 0;
+        }
+    }
+
+    // Peak resident memory of the process so far, in bytes (0 if unknown)
+    static size_t peakMemoryBytes()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS info;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &info, sizeof(info)))
+            return info.PeakWorkingSetSize;
+        return 0;
+#else
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+#if defined(__APPLE__)
+        return static_cast<size_t>(usage.ru_maxrss);
+#else
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+
+    // One JSON object per thread that recorded anything, then the totals
+    static void writeJsonLines(std::ostream &out)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        uint64_t totals[COUNTERS] = {};
+        for (auto &t : r.threads)
+        {
+            std::lock_guard<std::mutex> phaseLock(t->mutex);
+            uint64_t values[COUNTERS];
+            bool any = !t->phases.empty();
+            for (size_t i = 0; i < COUNTERS; i++)
+            {
+                values[i] = t->counters[i].load(std::memory_order_relaxed);
+                totals[i] += values[i];
+                any = any || values[i] != 0;
+            }
+            if (!any)
+                continue;
+            out << "{\"thread\": " << t->id << ", \"counters\": " << counters(values) << ", \"phases\": [";
+            for (size_t i = 0; i < t->phases.size(); i++)
+            {
+                const Phase &p = t->phases[i];
+                out << (i == 0 ? "" : ", ") << "{\"name\": \"" << p.name << "\", \"calls\": " << p.calls
+                    << ", \"seconds\": " << number(p.seconds) << ", \"max_seconds\": " << number(p.maxSeconds)
+                    << ", \"peak_memory_bytes\": " << p.peakMemory << "}";
+            }
+            out << "], \"dropped_trace_events\": " << t->droppedEvents << "}\n";
+        }
+        out << "{\"thread\": \"all\", \"counters\": " << counters(totals)
+            << ", \"peak_memory_bytes\": " << peakMemoryBytes() << "}\n";
+    }
+
+    // Chrome trace-event format: one complete ("X") event per recorded phase
+    // with the sampled peak memory as a counter track, and each thread's
+    // counters at its last event
+    static void writeChromeTrace(std::ostream &out)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+        bool first = true;
+        auto separator = [&]
+        {
+            out << (first ? "\n" : ",\n");
+            first = false;
+        };
+        for (auto &t : r.threads)
+        {
+            std::lock_guard<std::mutex> phaseLock(t->mutex);
+            separator();
+            out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << t->id
+                << ", \"args\": {\"name\": \"thread " << t->id << "\"}}";
+            double last = 0;
+            for (const Event &e : t->events)
+            {
+                separator();
+                out << "{\"name\": \"" << e.name << "\", \"cat\": \"phase\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << t->id
+                    << ", \"ts\": " << number(e.start) << ", \"dur\": " << number(e.duration) << "}";
+                if (e.memory != 0)
+                {
+                    separator();
+                    out << "{\"name\": \"peak memory\", \"ph\": \"C\", \"pid\": 1, \"tid\": " << t->id
+                        << ", \"ts\": " << number(e.start + e.duration) << ", \"args\": {\"bytes\": " << e.memory << "}}";
+                }
+                last = std::max(last, e.start + e.duration);
+            }
+            uint64_t values[COUNTERS];
+            for (size_t i = 0; i < COUNTERS; i++)
+                values[i] = t->counters[i].load(std::memory_order_relaxed);
+            separator();
+            out << "{\"name\": \"counters\", \"ph\": \"C\", \"pid\": 1, \"tid\": " << t->id << ", \"ts\": " << number(last)
+                << ", \"args\": " << counters(values) << "}";
+        }
+        out << "]}\n";
+    }
+
+    // Times a scope; use AI_PHASE
+    class PhaseTimer
+    {
+    public:
+        explicit PhaseTimer(const char *name) : name(name), start(std::chrono::steady_clock::now()) {}
+
+        ~PhaseTimer()
+        {
+            local().endPhase(name, start, std::chrono::steady_clock::now());
+        }
+
+        PhaseTimer(const PhaseTimer &) = delete;
+        PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+    private:
+        const char *name;
+        std::chrono::steady_clock::time_point start;
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Phase
+    {
+        const char *name;
+        uint64_t calls;
+        double seconds;
+        double maxSeconds;
+        size_t peakMemory;
+    };
+
+    struct Event
+    {
+        const char *name;
+        double start;    // microseconds since the process started recording
+        double duration; // microseconds
+        size_t memory;   // sampled peak, or 0 if not sampled at this event
+    };
+
+    struct alignas(64) ThreadStats
+    {
+        std::atomic<uint64_t> counters[COUNTERS];
+        uint32_t id = 0;
+        std::mutex mutex; // guards the rest against concurrent export
+        std::vector<Phase> phases;
+        std::vector<Event> events;
+        size_t droppedEvents = 0;
+        Clock::time_point lastSample;
+
+        ThreadStats()
+        {
+            for (auto &c : counters)
+                c.store(0, std::memory_order_relaxed);
+        }
+
+        void endPhase(const char *name, Clock::time_point begin, Clock::time_point end)
+        {
+            double seconds = std::chrono::duration<double>(end - begin).count();
+            size_t memory = 0;
+            if (end - lastSample >= std::chrono::milliseconds(1))
+            {
+                memory = peakMemoryBytes();
+                lastSample = end;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = std::find_if(phases.begin(), phases.end(), [&](const Phase &p)
+                                   { return p.name == name || std::strcmp(p.name, name) == 0; });
+            if (it == phases.end())
+                it = phases.insert(phases.end(), Phase{name, 0, 0, 0, 0});
+            it->calls++;
+            it->seconds += seconds;
+            it->maxSeconds = std::max(it->maxSeconds, seconds);
+            it->peakMemory = std::max(it->peakMemory, memory);
+
+            if (!registry().tracing.load(std::memory_order_relaxed))
+                return;
+            if (events.size() >= MAX_TRACE_EVENTS)
+            {
+                droppedEvents++;
+                return;
+            }
+            double start = std::chrono::duration<double, std::micro>(begin - registry().origin).count();
+            events.push_back({name, start, seconds * 1e6, memory});
+        }
+    };
+
+    // Owns the stats of every thread that ever recorded anything, so they
+    // outlive their threads
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadStats>> threads;
+        std::atomic<bool> tracing{false};
+        Clock::time_point origin = Clock::now();
+    };
+
+    static Registry &registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    static inline thread_local ThreadStats *stats = nullptr;
+
+    static ThreadStats &local()
+    {
+        if (!stats)
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.threads.push_back(std::make_unique<ThreadStats>());
+            stats = r.threads.back().get();
+            stats->id = static_cast<uint32_t>(r.threads.size() - 1);
+        }
+        return *stats;
+    }
+
+    static std::string number(double value)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.9g", value);
+        return text;
+    }
+
+    static std::string counters(const uint64_t *values)
+    {
+        std::string json = "{";
+        for (size_t i = 0; i < COUNTERS; i++)
+            json += std::string(i == 0 ? "\"" : ", \"") + counterName(static_cast<Counter>(i)) + "\": " +
+                    std::to_string(values[i]);
+        return json + "}";
+    }
+
+    friend class InstrumentationExitReport;
+};
+
+// Writes the AI_STATS / AI_TRACE files when the program exits
+class InstrumentationExitReport
+{
+public:
+    InstrumentationExitReport()
+    {
+        // Created first, so the registry is destroyed after this report
+        Instrumentation::registry();
+        if (const char *trace = std::getenv("AI_TRACE"))
+            Instrumentation::setTracing(*trace != '\0');
+    }
+
+    ~InstrumentationExitReport()
+    {
+        if (const char *path = std::getenv("AI_STATS"); path && *path)
+        {
+            std::ofstream out(path);
+            Instrumentation::writeJsonLines(out);
+        }
+        if (const char *path = std::getenv("AI_TRACE"); path && *path)
+        {
+            std::ofstream out(path);
+            Instrumentation::writeChromeTrace(out);
+        }
+    }
+};
+
+// Counts events of one counter in a plain member and adds them to the
+// thread's counters on flush() or destruction, for code too hot for a
+// thread-local update per event. Copies start from zero. Without
+// AI_INSTRUMENTATION it is empty and its calls compile to nothing.
+template <Counter C>
+class CounterTally
+{
+public:
+#if defined(AI_INSTRUMENTATION) && AI_INSTRUMENTATION
+    CounterTally() = default;
+    CounterTally(const CounterTally &) {}
+
+    CounterTally &operator=(const CounterTally &)
+    {
+        return *this;
+    }
+
+    ~CounterTally()
+    {
+        flush();
+    }
+
+    void add(uint64_t n = 1)
+    {
+        count += n;
+    }
+
+    void flush()
+    {
+        if (count != 0)
+            Instrumentation::add(C, count);
+        count = 0;
+    }
+
+private:
+    uint64_t count = 0;
+#else
+    void add(uint64_t = 1) {}
+    void flush() {}
+#endif
+};
+
+#define AI_INSTRUMENTATION_CONCAT2(a, b) a##b
+#define AI_INSTRUMENTATION_CONCAT(a, b) AI_INSTRUMENTATION_CONCAT2(a, b)
+
+#if defined(AI_INSTRUMENTATION) && AI_INSTRUMENTATION
+inline InstrumentationExitReport instrumentationExitReport;
+#define AI_COUNT(counter) Instrumentation::add(Counter::counter)
+#define AI_COUNT_ADD(counter, n) Instrumentation::add(Counter::counter, static_cast<uint64_t>(n))
+#define AI_PHASE(name) Instrumentation::PhaseTimer AI_INSTRUMENTATION_CONCAT(aiPhase, __LINE__)(name)
+#else
+#define AI_COUNT(counter) ((void)0)
+#define AI_COUNT_ADD(counter, n) ((void)0)
+#define AI_PHASE(name) ((void)0)
+#endif
@@ -0,0 +1,494 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "indexed_heap.h"
+#include "instrumentation.h"
+
+// Generic state-space search: breadth-first, depth-first (depth-limited and
+// iterative deepening), uniform-cost, A* and IDA*, specialized at compile
+// time for a problem type that describes the state space:
+//
+//     struct Problem
+//     {
+//         using State = ...; // small, copyable, comparable with ==
+//         using Cost = ...;  // arithmetic step cost
+//
+//         bool isGoal(const State &s) const;
+//         // Calls visit(next, stepCost) for every successor of s
+//         template <class Visit> void successors(const State &s, Visit &&visit) const;
+//         uint64_t hash(const State &s) const;
+//         // Admissible lower bound on the remaining cost; only A* and IDA* call it
+//         Cost heuristic(const State &s) const;
+//     };
+//
+// Every state a search reaches becomes one node in a flat pool (state, cost,
+// parent index, depth) and the closed set is an open-addressing table of node
+// indices into that pool, so a search allocates nothing per state and parents
+// are 32-bit indices rather than pointers or copies of states. The pool, the
+// table and the heap of A* are reused by every search on the same Search
+// object: table slots carry the generation of the search that wrote them, so
+// starting a new search costs O(1), like SearchContext in a_star.h.
+// One Search object serves one thread; problems are only read.
+//
+// With AI_INSTRUMENTATION each search adds its counts to the counters of
+// instrumentation.h when it returns and is timed as a phase.
+template <class Problem>
+class Search
+{
+public:
+    using State = typename Problem::State;
+    using Cost = typename Problem::Cost;
+
+    static constexpr Cost INFINITE_COST =
+        std::numeric_limits<Cost>::has_infinity ? std::numeric_limits<Cost>::infinity() : std::numeric_limits<Cost>::max();
+
+    // Fewest steps; the goal test happens when a state is generated
+    bool breadthFirst(const Problem &problem, const State &start)
+    {
+        AI_PHASE("search.breadth_first");
+        Recorder recorder{*this};
+        begin();
+        uint32_t root = add(problem, start, 0, NONE, 0);
+        if (problem.isGoal(start))
+            return finish(root);
+        for (uint32_t head = 0; head < nodes.size(); head++)
+        {
+            // The pool is also the FIFO queue: nodes are added in the order BFS reaches them
+            const Node current = nodes[head];
+            uint32_t goal = NONE;
+            expanded++;
+            problem.successors(current.state, [&](const State &next, Cost step)
+                               {
+                                   generated++;
+                                   if (goal != NONE)
+                                       return;
+                                   if (find(problem, next) != NONE)
+                                   {
+                                       duplicates++;
+                                       return;
+                                   }
+                                   uint32_t node = add(problem, next, current.g + step, head, current.depth + 1);
+                                   if (problem.isGoal(next))
+                                       goal = node; });
+            if (goal != NONE)
+                return finish(goal);
+        }
+        return false;
+    }
+
+    // Depth-first down to `limit` steps. A state is searched again only when
+    // it is reached on a shorter path than before, so every goal within the
+    // limit is found, unlike with a plain visited set.
+    bool depthFirst(const Problem &problem, const State &start, uint32_t limit)
+    {
+        AI_PHASE("search.depth_first");
+        Recorder recorder{*this};
+        begin();
+        stack.clear();
+        stack.push_back({start, 0, NONE, 0});
+        while (!stack.empty())
+        {
+            Node entry = stack.back();
+            stack.pop_back();
+            uint32_t node = find(problem, entry.state);
+            if (node == NONE)
+                node = add(problem, entry.state, entry.g, entry.parent, entry.depth);
+            else if (nodes[node].depth > entry.depth)
+                nodes[node] = entry;
+            else
+            {
+                duplicates++;
+                continue;
+            }
+            if (problem.isGoal(entry.state))
+                return finish(node);
+            if (entry.depth == limit)
+                continue;
+
+            expanded++;
+            size_t first = stack.size();
+            problem.successors(entry.state, [&](const State &next, Cost step)
+                               {
+                                   generated++;
+                                   stack.push_back({next, entry.g + step, node, entry.depth + 1}); });
+            // Explore successors in the order the problem lists them
+            std::reverse(stack.begin() + first, stack.end());
+        }
+        return false;
+    }
+
+    // Depth-first with limits 0, 1, ..., maxDepth; finds a goal in the fewest steps
+    bool iterativeDeepening(const Problem &problem, const State &start, uint32_t maxDepth)
+    {
+        size_t totalExpanded = 0, totalGenerated = 0, totalDuplicates = 0;
+        for (uint32_t limit = 0; limit <= maxDepth; limit++)
+        {
+            bool found = depthFirst(problem, start, limit);
+            totalExpanded += expanded;
+            totalGenerated += generated;
+            totalDuplicates += duplicates;
+            expanded = totalExpanded;
+            generated = totalGenerated;
+            duplicates = totalDuplicates;
+            if (found)
+                return true;
+        }
+        return false;
+    }
+
+    // Cheapest path (Dijkstra's algorithm)
+    bool uniformCost(const Problem &problem, const State &start)
+    {
+        return bestFirst<false>(problem, start);
+    }
+
+    // Cheapest path, guided by problem.heuristic(); optimal when it is admissible
+    bool aStar(const Problem &problem, const State &start)
+    {
+        return bestFirst<true>(problem, start);
+    }
+
+    // A* in memory linear in the solution depth: depth-first passes bounded by
+    // f = g + h, each bound the smallest f that exceeded the one before. Only
+    // states on the current path are stored, so it suits problems with
+    // billions of states and an admissible heuristic, like sliding puzzles.
+    bool idaStar(const Problem &problem, const State &start, Cost maxCost = INFINITE_COST)
+    {
+        AI_PHASE("search.ida_star");
+        Recorder recorder{*this};
+        resetResults();
+        if (problem.isGoal(start))
+        {
+            solution.push_back(start);
+            return true;
+        }
+        Cost bound = problem.heuristic(start);
+        while (bound <= maxCost)
+        {
+            Cost nextBound = INFINITE_COST;
+            frames.clear();
+            branches.clear();
+            push(problem, start, 0);
+            while (!frames.empty())
+            {
+                Frame &frame = frames.back();
+                if (frame.next == frame.end)
+                {
+                    branches.resize(frame.first);
+                    frames.pop_back();
+                    continue;
+                }
+                Branch branch = branches[frame.next++];
+                Cost g = frame.g + branch.cost;
+                Cost f = g + problem.heuristic(branch.state);
+                generated++;
+                if (f > bound)
+                {
+                    nextBound = std::min(nextBound, f);
+                    continue;
+                }
+                if (onPath(branch.state))
+                {
+                    duplicates++;
+                    continue;
+                }
+                if (problem.isGoal(branch.state))
+                {
+                    for (const Frame &ancestor : frames)
+                        solution.push_back(ancestor.state);
+                    solution.push_back(branch.state);
+                    pathCost = g;
+                    return true;
+                }
+                push(problem, branch.state, g);
+            }
+            if (nextBound == INFINITE_COST)
+                break;
+            bound = nextBound;
+        }
+        return false;
+    }
+
+    // --- Results of the last search ---
+
+    // States from the start to the goal found
+    const std::vector<State> &path() const
+    {
+        return solution;
+    }
+
+    Cost cost() const
+    {
+        return pathCost;
+    }
+
+    size_t expandedCount() const
+    {
+        return expanded;
+    }
+
+    size_t generatedCount() const
+    {
+        return generated;
+    }
+
+    // Successors dropped because their state was already stored with a
+    // path at least as good (or, in IDA*, is on the current path)
+    size_t duplicateCount() const
+    {
+        return duplicates;
+    }
+
+    // States held in the pool by the last search (0 after IDA*)
+    size_t storedCount() const
+    {
+        return nodes.size();
+    }
+
+private:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    struct Node
+    {
+        State state;
+        Cost g;
+        uint32_t parent;
+        uint32_t depth;
+    };
+
+    struct Slot
+    {
+        uint32_t node;
+        uint32_t stamp; // the generation that wrote `node`
+    };
+
+    // A* orders by f and, among equal f, prefers the deeper node, which
+    // reaches a goal sooner when many paths tie
+    struct Key
+    {
+        Cost f;
+        Cost g;
+
+        bool operator<(const Key &other) const
+        {
+            return f < other.f || (f == other.f && g > other.g);
+        }
+    };
+
+    struct Branch
+    {
+        State state;
+        Cost cost;
+    };
+
+    struct Frame
+    {
+        State state;
+        Cost g;
+        size_t first; // successors in branches[first .. end)
+        size_t next;
+        size_t end;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Slot> slots;
+    unsigned shift = 64;
+    uint32_t generation = 1; // slots start at stamp 0, which no search uses
+    IndexedDaryHeap<Key> open;
+    std::vector<Node> stack;
+    std::vector<Frame> frames;
+    std::vector<Branch> branches;
+
+    std::vector<State> solution;
+    Cost pathCost = 0;
+    size_t expanded = 0;
+    size_t generated = 0;
+    size_t duplicates = 0;
+
+    // Adds the counts of the search to the instrumentation counters when the
+    // search returns; does nothing without AI_INSTRUMENTATION
+    struct Recorder
+    {
+        const Search &search;
+
+        ~Recorder()
+        {
+            AI_COUNT_ADD(NodesExpanded, search.expanded);
+            AI_COUNT_ADD(NodesGenerated, search.generated);
+            AI_COUNT_ADD(DuplicatesPruned, search.duplicates);
+        }
+    };
+
+    template <bool Informed>
+    bool bestFirst(const Problem &problem, const State &start)
+    {
+        AI_PHASE(Informed ? "search.astar" : "search.uniform_cost");
+        Recorder recorder{*this};
+        begin();
+        open.clear();
+        auto key = [&](const State &s, Cost g)
+        {
+            if constexpr (Informed)
+                return Key{g + problem.heuristic(s), g};
+            else
+                return Key{g, g};
+        };
+        uint32_t root = add(problem, start, 0, NONE, 0);
+        open.reserveIds(nodes.size());
+        open.push(root, key(start, 0));
+        while (!open.empty())
+        {
+            uint32_t current = open.pop();
+            if (problem.isGoal(nodes[current].state))
+                return finish(current);
+
+            const Node parent = nodes[current];
+            expanded++;
+            problem.successors(parent.state, [&](const State &next, Cost step)
+                               {
+                                   generated++;
+                                   Cost g = parent.g + step;
+                                   uint32_t node = find(problem, next);
+                                   if (node == NONE)
+                                   {
+                                       node = add(problem, next, g, current, parent.depth + 1);
+                                       open.reserveIds(nodes.size());
+                                       open.push(node, key(next, g));
+                                       return;
+                                   }
+                                   if (!(g < nodes[node].g))
+                                   {
+                                       duplicates++;
+                                       return;
+                                   }
+                                   Cost saved = nodes[node].g - g;
+                                   nodes[node] = {next, g, current, parent.depth + 1};
+                                   if (open.contains(node))
+                                   {
+                                       // h does not change, so f drops by exactly what g saved
+                                       Key k = open.key(node);
+                                       open.decreaseKey(node, {k.f - saved, g});
+                                   }
+                                   else
+                                   {
+                                       // Only possible when h is not consistent: reopen the closed node
+                                       open.push(node, key(next, g));
+                                   } });
+        }
+        return false;
+    }
+
+    void resetResults()
+    {
+        solution.clear();
+        pathCost = 0;
+        expanded = 0;
+        generated = 0;
+        duplicates = 0;
+    }
+
+    // Starts a new search on the pool and the table
+    void begin()
+    {
+        resetResults();
+        nodes.clear();
+        if (++generation == 0)
+        {
+            // Stamps wrapped around: forget every old slot once
+            for (Slot &s : slots)
+                s.stamp = 0;
+            generation = 1;
+        }
+        if (slots.empty())
+            resize(1024);
+    }
+
+    bool finish(uint32_t goal)
+    {
+        for (uint32_t n = goal; n != NONE; n = nodes[n].parent)
+            solution.push_back(nodes[n].state);
+        std::reverse(solution.begin(), solution.end());
+        pathCost = nodes[goal].g;
+        return true;
+    }
+
+    size_t slotOf(const Problem &problem, const State &s) const
+    {
+        // Fibonacci hashing spreads even identity hashes of dense ids
+        return static_cast<size_t>((problem.hash(s) * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    uint32_t find(const Problem &problem, const State &s) const
+    {
+        size_t mask = slots.size() - 1;
+        for (size_t i = slotOf(problem, s);; i = (i + 1) & mask)
+        {
+            const Slot &slot = slots[i];
+            if (slot.stamp != generation)
+                return NONE;
+            if (nodes[slot.node].state == s)
+                return slot.node;
+        }
+    }
+
+    // Adds a state that is not in the table yet
+    uint32_t add(const Problem &problem, const State &s, Cost g, uint32_t parent, uint32_t depth)
+    {
+        uint32_t node = static_cast<uint32_t>(nodes.size());
+        nodes.push_back({s, g, parent, depth});
+        if (nodes.size() * 2 > slots.size())
+            resize(slots.size() * 2, problem);
+        else
+            place(problem, node);
+        return node;
+    }
+
+    void place(const Problem &problem, uint32_t node)
+    {
+        size_t mask = slots.size() - 1;
+        size_t i = slotOf(problem, nodes[node].state);
+        while (slots[i].stamp == generation)
+            i = (i + 1) & mask;
+        slots[i] = {node, generation};
+    }
+
+    void resize(size_t capacity)
+    {
+        slots.assign(capacity, Slot{NONE, 0});
+        shift = 64;
+        for (size_t c = capacity; c > 1; c >>= 1)
+            shift--;
+    }
+
+    // Grows the table and places every node of the current search again
+    void resize(size_t capacity, const Problem &problem)
+    {
+        resize(capacity);
+        for (uint32_t n = 0; n < nodes.size(); n++)
+            place(problem, n);
+    }
+
+    void push(const Problem &problem, const State &s, Cost g)
+    {
+        expanded++;
+        size_t first = branches.size();
+        problem.successors(s, [&](const State &next, Cost step)
+                           { branches.push_back({next, step}); });
+        frames.push_back({s, g, first, first, branches.size()});
+    }
+
+    bool onPath(const State &s) const
+    {
+        for (const Frame &f : frames)
+        {
+            if (f.state == s)
+                return true;
+        }
+        return false;
+    }
+};
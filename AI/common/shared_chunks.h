@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Array split into chunks of 2^Shift elements that copies of it share.
+// Copying the array copies only its table of chunks, and the first write to a
+// chunk that another copy still holds copies that chunk. A new version of a
+// large array therefore costs O(size / chunk) plus the chunks it changes, and
+// the old version stays intact for whoever still reads it.
+//
+// Sharing is decided by the reference count of each chunk. Only one thread may
+// copy or write the copies of one array; any thread may read or destroy the
+// copies it holds (a count that is read too high only costs a needless copy).
+template <class T, unsigned Shift = 10>
+class SharedChunks
+{
+public:
+    static constexpr size_t CHUNK = size_t(1) << Shift;
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    const T &operator[](size_t i) const
+    {
+        return data[i >> Shift][i & (CHUNK - 1)];
+    }
+
+    // Element i for writing; copies its chunk first if it is shared
+    T &at(size_t i)
+    {
+        return own(i >> Shift)[i & (CHUNK - 1)];
+    }
+
+    void push_back(const T &value)
+    {
+        resize(count + 1, value);
+    }
+
+    // New elements are set to `value`; chunks past the end are dropped
+    void resize(size_t size, const T &value = T())
+    {
+        size_t chunkCount = (size + CHUNK - 1) >> Shift;
+        if (size < count)
+        {
+            chunks.resize(chunkCount);
+            data.resize(chunkCount);
+            count = size;
+            return;
+        }
+        while (chunks.size() < chunkCount)
+        {
+            chunks.emplace_back(new T[CHUNK]());
+            data.push_back(chunks.back().get());
+        }
+        for (size_t i = count; i < size;)
+        {
+            size_t end = std::min(size, ((i >> Shift) + 1) << Shift);
+            T *chunk = own(i >> Shift);
+            std::fill(chunk + (i & (CHUNK - 1)), chunk + (i & (CHUNK - 1)) + (end - i), value);
+            i = end;
+        }
+        count = size;
+    }
+
+    void assign(size_t size, const T &value)
+    {
+        clear();
+        resize(size, value);
+    }
+
+    void clear()
+    {
+        chunks.clear();
+        data.clear();
+        count = 0;
+    }
+
+private:
+    std::vector<std::shared_ptr<T[]>> chunks;
+    std::vector<T *> data; // chunks[c].get(), one indirection less for reads
+    size_t count = 0;
+
+    T *own(size_t c)
+    {
+        if (chunks[c].use_count() > 1)
+        {
+            std::shared_ptr<T[]> copy(new T[CHUNK]);
+            std::copy(data[c], data[c] + CHUNK, copy.get());
+            chunks[c] = std::move(copy);
+            data[c] = chunks[c].get();
+        }
+        return data[c];
+    }
+};
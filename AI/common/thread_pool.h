@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads.
+// Tasks receive the index of the worker running them (0 .. size() - 1), so
+// callers can keep per-worker scratch state without locking.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency())
+    {
+        threads = std::max<size_t>(threads, 1);
+        for (size_t i = 0; i < threads; i++)
+            workers.emplace_back([this, i]
+                                 { workerLoop(i); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t size() const
+    {
+        return workers.size();
+    }
+
+    void submit(std::function<void(size_t worker)> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    // Runs body(worker, i) for every i in [0, count) and waits for all of them.
+    // Indices are handed out in chunks of `grain` through a shared counter, so
+    // uneven work balances itself across the workers. Must not be called from
+    // inside a pool task, since the caller blocks until the loop is finished.
+    template <class Body>
+    void parallelFor(size_t count, Body body, size_t grain = 1)
+    {
+        if (count == 0)
+            return;
+        grain = std::max<size_t>(grain, 1);
+        std::atomic<size_t> next{0};
+        size_t helpers = std::min(size(), (count + grain - 1) / grain);
+
+        std::mutex doneMutex;
+        std::condition_variable doneSignal;
+        size_t running = helpers;
+
+        for (size_t h = 0; h < helpers; h++)
+        {
+            submit([&](size_t worker)
+                   {
+                       for (size_t begin = next.fetch_add(grain); begin < count; begin = next.fetch_add(grain))
+                       {
+                           size_t end = std::min(count, begin + grain);
+                           for (size_t i = begin; i < end; i++)
+                               body(worker, i);
+                       }
+                       std::lock_guard<std::mutex> lock(doneMutex);
+                       if (--running == 0)
+                           doneSignal.notify_one(); });
+        }
+
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneSignal.wait(lock, [&]
+                        { return running == 0; });
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void(size_t)>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void workerLoop(size_t index)
+    {
+        for (;;)
+        {
+            std::function<void(size_t)> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]
+                          { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task(index);
+        }
+    }
+};